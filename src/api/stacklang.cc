@@ -0,0 +1,176 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the C interface, on top of Interpreter.
+
+#include "api/stacklang.h"
+
+#include <charconv>
+#include <cmath>
+#include <exception>
+#include <new>
+#include <string>
+#include <system_error>
+
+#include "language/exceptions/languageExceptions.h"
+#include "language/interpreter.h"
+#include "language/stack/lexer.h"
+#include "language/stack/stackElements.h"
+#include "util/stringUtils.h"
+
+struct stacklang_context {
+  stacklang::Interpreter interpreter;
+  std::string text;   // last element peeked at
+  std::string error;  // of the last call
+  bool failed = false;
+
+  stacklang_context() = default;
+  explicit stacklang_context(std::string_view image) : interpreter{image} {}
+};
+
+namespace {
+using stacklang::Lexer;
+using stacklang::Stack;
+using stacklang::Value;
+using stacklang::exceptions::LanguageException;
+using stacklang::exceptions::StopError;
+using stacklang::stackelements::StringElement;
+using std::exception;
+using std::chars_format;
+using std::errc;
+using std::isfinite;
+using std::nothrow;
+using std::string;
+using std::to_chars;
+using util::spaces;
+
+// Formats an error the way the interpreter prints it.
+string format(const LanguageException& exn) {
+  string message = exn.getKind() + "\n" + exn.getMessage() + "\n";
+  if (exn.hasContext()) {
+    message += exn.getContext() + "\n" + spaces(exn.getLocation()) + "^\n";
+  }
+  if (!exn.getTrace().empty()) {
+    message += "\n";
+    for (const string& ctx : exn.getTrace()) message += "From " + ctx + "\n";
+  }
+  return message;
+}
+
+// Runs the action, recording any error it throws in the context.
+template <typename Action>
+stacklang_status attempt(stacklang_context* context, Action action) noexcept {
+  context->failed = false;
+  context->error.clear();
+  try {
+    action();
+    return STACKLANG_OK;
+  } catch (const StopError& exn) {
+    context->failed = true;
+    context->error = format(exn);
+    return STACKLANG_STOPPED;
+  } catch (const LanguageException& exn) {
+    context->failed = true;
+    context->error = format(exn);
+  } catch (const exception& exn) {
+    context->failed = true;
+    context->error = exn.what();
+  }
+  return STACKLANG_ERROR;
+}
+}  // namespace
+
+stacklang_context* stacklang_create(void) {
+  return new (nothrow) stacklang_context();
+}
+
+stacklang_context* stacklang_clone(stacklang_context* original) {
+  stacklang_context* copy = nullptr;
+  attempt(original, [original, &copy] {
+    copy = new stacklang_context(original->interpreter.makeImage());
+  });
+  return copy;
+}
+
+void stacklang_destroy(stacklang_context* context) { delete context; }
+
+stacklang_status stacklang_include(stacklang_context* context,
+                                   const char* library) {
+  return attempt(context,
+                 [context, library] { context->interpreter.include(library); });
+}
+
+stacklang_status stacklang_push(stacklang_context* context,
+                                const char* element) {
+  return attempt(context, [context, element] {
+    context->interpreter.getStack().push(Lexer(element).parseElement());
+  });
+}
+
+stacklang_status stacklang_push_number(stacklang_context* context,
+                                       double number) {
+  return attempt(context, [context, number] {
+    // read as its shortest decimal form would be, so it is shown that way.
+    char text[400];  // enough for any double in fixed notation
+    auto [end, err] = to_chars(text, text + sizeof(text), number,
+                               chars_format::fixed);
+    context->interpreter.getStack().push(
+        isfinite(number) && err == errc()
+            ? Lexer(string(text, end)).parseElement()
+            : Value(number));
+  });
+}
+
+stacklang_status stacklang_push_string(stacklang_context* context,
+                                       const char* text) {
+  return attempt(context, [context, text] {
+    context->interpreter.getStack().push(new StringElement(text));
+  });
+}
+
+stacklang_status stacklang_eval(stacklang_context* context, const char* text) {
+  return attempt(context, [context, text] { context->interpreter.eval(text); });
+}
+
+size_t stacklang_size(stacklang_context* context) {
+  return context->interpreter.getStack().size();
+}
+
+const char* stacklang_peek(stacklang_context* context, size_t index) {
+  const Stack& s = context->interpreter.getStack();
+  if (index >= s.size()) return nullptr;
+  context->text = static_cast<string>(s[index]);
+  return context->text.c_str();
+}
+
+stacklang_status stacklang_pop(stacklang_context* context) {
+  return attempt(context,
+                 [context] { context->interpreter.getStack().drop(); });
+}
+
+void stacklang_clear(stacklang_context* context) {
+  context->interpreter.getStack().clear();
+}
+
+const char* stacklang_error(stacklang_context* context) {
+  return context->failed ? context->error.c_str() : nullptr;
+}
+
+void stacklang_stop(stacklang_context* context) {
+  context->interpreter.stop();
+}
@@ -0,0 +1,91 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// C interface for embedding the interpreter, built into libstacklang by
+// `make library`.
+
+#ifndef STACKLANG_API_STACKLANG_H_
+#define STACKLANG_API_STACKLANG_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// An interpreter with its own stack and definitions. Different contexts may
+// be used on different threads at once, but each context by only one thread
+// at a time (except for stacklang_stop).
+typedef struct stacklang_context stacklang_context;
+
+typedef enum stacklang_status {
+  STACKLANG_OK = 0,
+  STACKLANG_ERROR,    // the message is given by stacklang_error
+  STACKLANG_STOPPED,  // stopped by stacklang_stop
+} stacklang_status;
+
+// Makes a context with only the primitives defined. Gives NULL if out of
+// memory.
+stacklang_context* stacklang_create(void);
+// Makes a context with a copy of the definitions of another, which is much
+// faster than including the same libraries again. Gives NULL on error, which
+// is reported by the original.
+stacklang_context* stacklang_clone(stacklang_context* original);
+void stacklang_destroy(stacklang_context* context);
+
+// Includes a library, as the include command does - `std` is the standard
+// library. Plain names are looked for in the libs folder of the working
+// directory.
+stacklang_status stacklang_include(stacklang_context* context,
+                                   const char* library);
+
+// Pushes an element given as text without executing it, or pushes a number
+// or a string.
+stacklang_status stacklang_push(stacklang_context* context,
+                                const char* element);
+stacklang_status stacklang_push_number(stacklang_context* context,
+                                       double number);
+stacklang_status stacklang_push_string(stacklang_context* context,
+                                       const char* text);
+
+// Runs each top level element of the text in turn, as if the text were an
+// included file.
+stacklang_status stacklang_eval(stacklang_context* context, const char* text);
+
+// Gets the number of elements on the stack, and the text of the element at
+// an index counted from the top, or NULL if there is no such element. The
+// text is valid until the next call with the context.
+size_t stacklang_size(stacklang_context* context);
+const char* stacklang_peek(stacklang_context* context, size_t index);
+stacklang_status stacklang_pop(stacklang_context* context);
+void stacklang_clear(stacklang_context* context);
+
+// Gets the message of the last error, formatted as the interpreter prints
+// it, or NULL if the last call succeeded. Valid until the next call with the
+// context.
+const char* stacklang_error(stacklang_context* context);
+
+// Makes the running evaluation of the context (or the next one) stop. May be
+// called from any thread.
+void stacklang_stop(stacklang_context* context);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // STACKLANG_API_STACKLANG_H_
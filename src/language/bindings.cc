@@ -0,0 +1,138 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the binding table.
+
+#include "language/bindings.h"
+
+namespace stacklang {
+namespace {
+using std::move;
+using std::vector;
+
+const size_t MIN_SLOTS = 8;
+}  // namespace
+
+Bindings::const_iterator::const_iterator(const Binding* c,
+                                         const Binding* e) noexcept
+    : curr{c}, end{e} {
+  while (curr != end && curr->first == Symbol()) curr++;
+}
+
+Bindings::const_iterator& Bindings::const_iterator::operator++() noexcept {
+  do {
+    curr++;
+  } while (curr != end && curr->first == Symbol());
+  return *this;
+}
+
+size_t Bindings::size() const noexcept { return count; }
+bool Bindings::empty() const noexcept { return count == 0; }
+
+const Value* Bindings::find(Symbol name) const noexcept {
+  if (count == 0) return nullptr;
+  const Binding& slot = slots[slotOf(name)];
+  return slot.first == name ? &slot.second : nullptr;
+}
+
+Value* Bindings::find(Symbol name) noexcept {
+  if (count == 0) return nullptr;
+  Binding& slot = slots[slotOf(name)];
+  return slot.first == name ? &slot.second : nullptr;
+}
+
+bool Bindings::insert(Symbol name, const Value& value) {
+  if (find(name) != nullptr) return false;
+  reserve();
+  slots[slotOf(name)] = Binding(name, value);
+  count++;
+  return true;
+}
+
+void Bindings::assign(Symbol name, const Value& value) {
+  Value* bound = find(name);
+  if (bound != nullptr) {
+    *bound = value;
+  } else {
+    insert(name, value);
+  }
+}
+
+bool Bindings::erase(Symbol name) noexcept {
+  if (count == 0) return false;
+  size_t hole = slotOf(name);
+  if (slots[hole].first != name) return false;
+  slots[hole] = Binding();
+  count--;
+
+  // move later names of the run back if the hole would hide them.
+  size_t mask = slots.size() - 1;
+  for (size_t curr = (hole + 1) & mask; slots[curr].first != Symbol();
+       curr = (curr + 1) & mask) {
+    size_t distance = (curr - home(slots[curr].first)) & mask;
+    if (distance >= ((curr - hole) & mask)) {
+      slots[hole] = move(slots[curr]);
+      slots[curr] = Binding();
+      hole = curr;
+    }
+  }
+  return true;
+}
+
+void Bindings::clear() noexcept {
+  slots.clear();
+  count = 0;
+}
+
+void Bindings::swap(Bindings& other) noexcept {
+  slots.swap(other.slots);
+  std::swap(count, other.count);
+}
+
+Bindings::const_iterator Bindings::begin() const noexcept {
+  return const_iterator(slots.data(), slots.data() + slots.size());
+}
+
+Bindings::const_iterator Bindings::end() const noexcept {
+  return const_iterator(slots.data() + slots.size(),
+                        slots.data() + slots.size());
+}
+
+size_t Bindings::slotOf(Symbol name) const noexcept {
+  size_t mask = slots.size() - 1;
+  size_t slot = home(name);
+  while (slots[slot].first != name && slots[slot].first != Symbol()) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+size_t Bindings::home(Symbol name) const noexcept {
+  return name.getId() & (slots.size() - 1);
+}
+
+void Bindings::reserve() {
+  if ((count + 1) * 4 <= slots.size() * 3) return;  // at most 3/4 full
+
+  vector<Binding> old(slots.empty() ? MIN_SLOTS : slots.size() * 2);
+  old.swap(slots);
+  for (Binding& binding : old) {
+    if (binding.first != Symbol()) slots[slotOf(binding.first)] = move(binding);
+  }
+}
+}  // namespace stacklang
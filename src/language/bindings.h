@@ -0,0 +1,97 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Names bound in an environment.
+
+#ifndef STACKLANG_LANGUAGE_BINDINGS_H_
+#define STACKLANG_LANGUAGE_BINDINGS_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "language/stack/stack.h"
+#include "language/stack/symbol.h"
+
+namespace stacklang {
+// Hash table from names to the values bound to them. Each name is placed by
+// its symbol's id, and collisions are placed in the next free slot. Values
+// move when names are added or removed, so pointers to them are only valid
+// until the bindings change.
+class Bindings {
+ public:
+  using Binding = std::pair<Symbol, Value>;
+
+  // Visits the bindings in no particular order.
+  class const_iterator {
+   public:
+    const Binding& operator*() const noexcept { return *curr; }
+    const Binding* operator->() const noexcept { return curr; }
+    const_iterator& operator++() noexcept;
+    bool operator==(const const_iterator& other) const noexcept {
+      return curr == other.curr;
+    }
+    bool operator!=(const const_iterator& other) const noexcept {
+      return curr != other.curr;
+    }
+
+   private:
+    friend class Bindings;
+
+    const_iterator(const Binding* c, const Binding* e) noexcept;
+
+    const Binding* curr;
+    const Binding* end;
+  };
+
+  Bindings() noexcept = default;
+
+  size_t size() const noexcept;
+  bool empty() const noexcept;
+
+  // Gets the value bound to the name, or nullptr.
+  const Value* find(Symbol) const noexcept;
+  Value* find(Symbol) noexcept;
+
+  // Binds the name if it is not bound. Gives whether it was bound.
+  bool insert(Symbol, const Value&);
+  // Binds the name, replacing any value it was bound to.
+  void assign(Symbol, const Value&);
+  // Unbinds the name. Gives whether it was bound.
+  bool erase(Symbol) noexcept;
+
+  void clear() noexcept;
+  void swap(Bindings&) noexcept;
+
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+
+ private:
+  // Finds the slot of the name, or the free slot it would go in. There must
+  // be a free slot.
+  size_t slotOf(Symbol) const noexcept;
+  size_t home(Symbol) const noexcept;
+  // Makes room for one more binding.
+  void reserve();
+
+  std::vector<Binding> slots;  // empty or a power of two long
+  size_t count = 0;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_BINDINGS_H_
@@ -0,0 +1,169 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the compiler and interpreter for defined command bodies.
+
+#include "language/bytecode.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include "language/exceptions/interpreterExceptions.h"
+#include "language/exceptions/languageExceptions.h"
+#include "language/language.h"
+#include "language/stack/stackElements.h"
+
+namespace stacklang {
+namespace {
+using exceptions::RuntimeError;
+using exceptions::StackOverflowError;
+using exceptions::StackUnderflowError;
+using stackelements::IdentifierElement;
+using std::atomic;
+using std::find;
+using std::find_if;
+
+// the last id given to a name, so no two names share an id.
+atomic<size_t> lastName = 0;
+}  // namespace
+
+Bytecode::Bytecode(const Stack& params, const Stack& body,
+                   Environment* closure) {
+  for (const Value& param : params) {
+    closure->params.push_back(
+        static_cast<const IdentifierElement*>(param.get())->getSymbol());
+  }
+
+  code.reserve(body.size());
+  for (const Value& elm : body) {  // from the top - in order of execution
+    if (elm.getType() != StackElement::DataType::Identifier ||
+        static_cast<const IdentifierElement*>(elm.get())->isQuoted()) {
+      code.push_back(Instruction{Opcode::Push, constants.size()});
+      constants.push_back(elm);
+      continue;
+    }
+
+    Symbol name = static_cast<const IdentifierElement*>(elm.get())->getSymbol();
+
+    Opcode op = Opcode::Global;
+    size_t depth = 0;
+    size_t slot = 0;
+    for (Environment* env = closure; env != nullptr; env = env->parent) {
+      auto param = find(env->params.begin(), env->params.end(), name);
+      if (param != env->params.end()) {
+        op = Opcode::Local;
+        slot = static_cast<size_t>(param - env->params.begin());
+        break;
+      }
+      depth++;
+    }
+
+    auto found = find_if(names.begin(), names.end(),
+                         [&name](const Name& n) { return n.name == name; });
+    code.push_back(
+        Instruction{op, static_cast<size_t>(found - names.begin())});
+    if (found == names.end()) {
+      names.push_back(Name{name, depth, slot, ++lastName});
+    }
+  }
+}
+
+size_t Bytecode::size() const noexcept { return code.size(); }
+
+void Bytecode::run(size_t pc, Stack& s, const Scope& scope,
+                   LookupCache& cache) const {
+  const Instruction& inst = code[pc];
+  if (inst.op == Opcode::Push) {
+    try {
+      s.push(constants[inst.operand]);
+    } catch (const StackOverflowError& exn) {
+      // stack error without trace must be main stack.
+      if (exn.getTrace().empty()) {
+        throw StackOverflowError(s.getLimit());
+      } else {
+        throw;
+      }
+    } catch (const StackUnderflowError& exn) {
+      if (exn.getTrace().empty()) {
+        throw StackUnderflowError();
+      } else {
+        throw;
+      }
+    }
+    return;
+  }
+
+  // the identifier itself would have been pushed before being looked up, so it
+  // has to fit.
+  if (s.size() >= s.getLimit()) throw StackOverflowError(s.getLimit());
+
+  const Name& name = names[inst.operand];
+  s.push(inst.op == Opcode::Local ? load(name, scope, cache)
+                                  : resolve(name, scope, cache));
+}
+
+const Value& Bytecode::load(const Name& name, const Scope& scope,
+                           LookupCache& cache) {
+  Scope curr = scope;
+  for (size_t depth = name.depth; depth > 0; depth--) {
+    // a definition may shadow the parameter
+    const Value* found = curr.getBindings().find(name.name);
+    if (found != nullptr) return *found;
+    curr = curr.getParent();
+  }
+
+  Value* slots = curr.getSlots();
+  if (slots != nullptr) return slots[name.slot];
+
+  // the command binding it is not running.
+  return resolve(name, curr, cache);
+}
+
+const Value& Bytecode::resolve(const Name& name, const Scope& scope,
+                              LookupCache& cache) {
+  // what a call defines differs from call to call, so it is not cached.
+  const Value* found = scope.getBindings().find(name.name);
+  if (found != nullptr) return *found;
+
+  if (!scope.isGlobal()) {
+    Scope parent = scope.getParent();
+    LookupCache::Entry& entry = cache.entryOf(name.id);
+    size_t version = scope.getEnv()->getVersion();
+    size_t outer = parent.getFrame() != nullptr ? parent.getFrame()->id : 0;
+    if (entry.name == name.id && entry.version == version &&
+        entry.outer == outer) {
+      return *entry.binding;
+    }
+
+    for (Scope curr = parent;; curr = curr.getParent()) {
+      found = curr.get(name.name);
+      if (found != nullptr) {
+        if (curr.isGlobal()) {
+          entry = LookupCache::Entry{name.id, version, outer, found};
+        }
+        return *found;
+      }
+      if (curr.isGlobal()) break;
+    }
+  }
+
+  if (scope.getEnv()->autoload(name.name)) return resolve(name, scope, cache);
+  throw RuntimeError("Cannot find identifier '" + name.name.getName() + "'.");
+}
+}  // namespace stacklang
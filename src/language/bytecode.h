@@ -0,0 +1,113 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Compiled form of the body of a defined command.
+
+#ifndef STACKLANG_LANGUAGE_BYTECODE_H_
+#define STACKLANG_LANGUAGE_BYTECODE_H_
+
+#include <vector>
+
+#include "language/environment.h"
+#include "language/stack/stack.h"
+#include "language/stack/symbol.h"
+
+namespace stacklang {
+class Scope;
+
+// Where global names were last found by compiled bodies, kept by each context
+// instead of in the bodies, so running a body never changes it. Names share
+// entries, so an entry is only used by the name that made it, only while the
+// version of the tree it was found in is current, and only from calls seeing
+// the same enclosing call. Calls are numbered by the cache they use.
+class LookupCache {
+ public:
+  struct Entry {
+    size_t name;  // id of the name that made it, or zero
+    size_t version;
+    size_t outer;  // id of the nearest call enclosing the lookup, or zero
+    const Value* binding;
+  };
+
+  LookupCache() noexcept : calls{0} {}
+
+  Entry& entryOf(size_t name) {
+    if (entries.empty()) entries.resize(SIZE);
+    return entries[name & (SIZE - 1)];
+  }
+
+  // Gives an id for a new call.
+  size_t nextCall() noexcept { return ++calls; }
+
+ private:
+  static constexpr size_t SIZE = 512;  // a power of two
+
+  std::vector<Entry> entries;
+  size_t calls;
+};
+
+// The body of a defined command, compiled when the command is defined.
+// Literals are pushed directly. Parameters of the command and of enclosing
+// commands are compiled to the depth of the environment binding them and
+// their slot there. Other names are looked up once and then read through a
+// pointer to their global binding, kept in a LookupCache, until a binding
+// changes.
+class Bytecode {
+ public:
+  // Compiles a body, given the parameters and closure of its command. Records
+  // the parameter names in the closure.
+  Bytecode(const Stack& params, const Stack& body, Environment* closure);
+
+  size_t size() const noexcept;
+
+  // Runs one instruction in the scope of a call of the command, pushing the
+  // constant or the value it loads. Commands pushed this way are left to the
+  // caller to execute.
+  void run(size_t pc, Stack&, const Scope&, LookupCache&) const;
+
+ private:
+  enum class Opcode : unsigned char {
+    Push,    // pushes a constant
+    Local,   // loads a parameter of this or an enclosing command
+    Global,  // loads any other name, caching where it is bound globally
+  };
+
+  struct Instruction {
+    Opcode op;
+    size_t operand;  // index into constants or names
+  };
+
+  struct Name {
+    Symbol name;
+    size_t depth;  // of the environment binding a Local, counted from this one
+    size_t slot;   // of a Local in that environment
+    size_t id;     // unique to this name, for its LookupCache entries
+  };
+
+  // Finds what a Local name is bound to.
+  static const Value& load(const Name&, const Scope&, LookupCache&);
+  // Finds what a Global name is bound to, using and updating the cache.
+  static const Value& resolve(const Name&, const Scope&, LookupCache&);
+
+  std::vector<Instruction> code;
+  std::vector<Value> constants;
+  std::vector<Name> names;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_BYTECODE_H_
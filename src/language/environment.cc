@@ -18,92 +18,36 @@
 
 // environment tree implementation
 
-#define _USE_MATH_DEFINES
-
 #include "language/environment.h"
 
-#include "language/exceptions/interpreterExceptions.h"
+#include <atomic>
+
 #include "language/exceptions/languageExceptions.h"
 #include "language/language.h"
+#include "language/primitives.h"
 #include "language/stack/stackElements.h"
-#include "util/mathUtils.h"
-#include "util/stringUtils.h"
-
-#include <cmath>
-#include <fstream>
-#include <random>
-#include <stack>
-
-#define PRIMDEF(name, body) \
-  {name, new PrimitiveCommandElement([](Stack & s, Environment * e) body)},
 
 namespace stacklang {
 namespace {
 using exceptions::RuntimeError;
+using stackelements::IdentifierElement;
 using stackelements::PrimitiveCommandElement;
-using stacklang::exceptions::ParserException;
-using stacklang::exceptions::RuntimeError;
-using stacklang::exceptions::StackOverflowError;
-using stacklang::exceptions::StackUnderflowError;
-using stacklang::exceptions::StopError;
-using stacklang::exceptions::SyntaxError;
-using stacklang::exceptions::TypeError;
-using stacklang::stackelements::BooleanElement;
-using stacklang::stackelements::BooleanPtr;
-using stacklang::stackelements::CommandElement;
-using stacklang::stackelements::CommandPtr;
-using stacklang::stackelements::DefinedCommandElement;
-using stacklang::stackelements::DefinedCommandPtr;
-using stacklang::stackelements::IdentifierElement;
-using stacklang::stackelements::IdentifierPtr;
-using stacklang::stackelements::NumberElement;
-using stacklang::stackelements::NumberPtr;
-using stacklang::stackelements::PrimitiveCommandElement;
-using stacklang::stackelements::PrimitiveCommandPtr;
-using stacklang::stackelements::StringElement;
-using stacklang::stackelements::StringPtr;
-using stacklang::stackelements::SubstackElement;
-using stacklang::stackelements::SubstackPtr;
-using stacklang::stackelements::TypeElement;
-using stacklang::stackelements::TypePtr;
-using std::abs;
-using std::acosh;
-using std::all_of;
-using std::asinh;
-using std::atanh;
-using std::begin;
-using std::copysign;
-using std::cos;
-using std::cosh;
-using std::end;
-using std::find_if;
-using std::ifstream;
-using std::isnan;
-using std::istringstream;
-using std::log;
-using std::make_unique;
-using std::map;
-using std::max;
-using std::min;
-using std::modf;
-using std::pair;
-using std::pow;
-using std::random_device;
-using std::sin;
-using std::sinh;
-using std::stack;
+using stackelements::StringElement;
+using std::atomic;
 using std::string;
-using std::tan;
-using std::tanh;
-using std::to_string;
-using std::vector;
-using util::ends_with;
-using util::spaceship;
-using util::starts_with;
-using util::trim;
+
+// the last version given to any tree, so no two trees share a version.
+atomic<size_t> lastVersion = 0;
+
+size_t nextVersion() noexcept { return ++lastVersion; }
 }  // namespace
 
-EnvTree::Environment::Environment(Environment* p) noexcept : parent{p} {
+EnvTree::Environment::Environment(Environment* p) noexcept
+    : parent{p},
+      changes{p == nullptr ? nextVersion() : 0},
+      version{p != nullptr ? p->version : &changes},
+      stamp{p != nullptr ? p->stamp : &edits},
+      edits{changes} {
   if (parent != nullptr) parent->children.push_back(this);
 }
 
@@ -112,35 +56,82 @@ EnvTree::Environment::~Environment() noexcept {
   clearBindings();
 }
 
-StackElement* EnvTree::Environment::lookup(const string& id) {
-  auto iter = bindings.find(id);
-  if (iter == bindings.cend()) {
-    if (parent == nullptr) {
-      throw RuntimeError("Cannot find identifier '" + id + "'.");
-    } else {
-      return parent->lookup(id);
-    }
-  } else {
-    return iter->second->clone();
+const Value* EnvTree::Environment::find(Symbol id) {
+  for (Environment* curr = this; curr != nullptr; curr = curr->parent) {
+    const Value* binding = curr->get(id);
+    if (binding != nullptr) return binding;
   }
+
+  return autoload(id) ? find(id) : nullptr;
+}
+
+const Value& EnvTree::Environment::lookup(Symbol id) {
+  const Value* binding = find(id);
+  if (binding == nullptr) {
+    throw RuntimeError("Cannot find identifier '" + id.getName() + "'.");
+  }
+  return *binding;
 }
 
-void EnvTree::Environment::clearBindings() noexcept {
-  for (auto& elm : bindings) delete elm.second;
-  bindings.clear();
+const Value* EnvTree::Environment::get(Symbol id) const noexcept {
+  return bindings.find(id);
 }
 
+void EnvTree::Environment::clearBindings() noexcept { bindings.clear(); }
+
+bool EnvTree::Environment::autoload(Symbol id) {
+  Environment* root = this;
+  while (root->parent != nullptr) root = root->parent;
+
+  auto iter = root->autoloads.find(id);
+  if (iter == root->autoloads.end()) return false;
+
+  // all names of the module are loaded with it.
+  string module = iter->second;
+  for (iter = root->autoloads.begin(); iter != root->autoloads.end();) {
+    iter = iter->second == module ? root->autoloads.erase(iter) : ++iter;
+  }
+  root->modulesChanged();
+
+  Stack s;
+  s.push(new StringElement(module));
+  s.push(new IdentifierElement("include"));
+  execute(s, root);
+  return true;
+}
+
+void EnvTree::Environment::bindingChanged(Symbol id) noexcept {
+  // only names found in the root are cached, so only changes there or
+  // shadowing names there matter.
+  const Environment* root = this;
+  while (root->parent != nullptr) root = root->parent;
+  *stamp = nextVersion();
+  if (root == this || root->bindings.find(id) != nullptr) *version = *stamp;
+}
+
+void EnvTree::Environment::modulesChanged() noexcept { *stamp = nextVersion(); }
+
+void EnvTree::Environment::autoloadAll() {
+  while (!autoloads.empty()) autoload(autoloads.begin()->first);
+}
+
+size_t EnvTree::Environment::getVersion() const noexcept { return *version; }
+
+size_t EnvTree::Environment::getStamp() const noexcept { return *stamp; }
+
 EnvTree::EnvTree() noexcept {
+  // every tree starts with the same bindings, so they are only made once.
+  static const Bindings primitives = [] {
+    Bindings bindings;
+    for (size_t opcode = 0; opcode < NUM_PRIMITIVES; opcode++) {
+      bindings.insert(Symbol(PRIMITIVES[opcode].name),
+                      new PrimitiveCommandElement(opcode));
+    }
+    return bindings;
+  }();
+
   root = new Environment(nullptr);
-  root->bindings = map<string, StackElement*>{
-#include "language/primitives/boolean.inc"
-#include "language/primitives/command.inc"
-#include "language/primitives/number.inc"
-#include "language/primitives/special.inc"
-#include "language/primitives/string.inc"
-#include "language/primitives/substack.inc"
-#include "language/primitives/type.inc"
-  };
+  root->bindings = primitives;
 }
 
 EnvTree::~EnvTree() noexcept { delete root; }
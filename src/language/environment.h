@@ -21,9 +21,12 @@
 #ifndef STACKLANG_LANGUAGE_ENVIRONMENT_H_
 #define STACKLANG_LANGUAGE_ENVIRONMENT_H_
 
+#include "language/bindings.h"
 #include "language/stack/stack.h"
+#include "language/stack/symbol.h"
 
 #include <map>
+#include <string>
 #include <vector>
 
 namespace stacklang {
@@ -31,9 +34,24 @@ class EnvTree {
  public:
   class Environment {
    public:
-    std::map<std::string, StackElement*> bindings;
+    // Global definitions in the root. Other environments only have those an
+    // image saved from a call that was running.
+    Bindings bindings;
     Environment* parent;
 
+    // Names bound on every call of the defined command that owns this
+    // environment (empty for environments not owned by a command). Their
+    // values, and what each call defines, are kept by the call's Frame.
+    std::vector<Symbol> params;
+
+    // Modules to include the first time a name they define is looked up, by
+    // name. Only used in the root.
+    std::map<Symbol, std::string> autoloads;
+    // Seconds taken to include each module, counting the modules it included,
+    // by canonical path. Zero while the module is being included. Only used
+    // in the root.
+    std::map<std::string, double> modules;
+
     Environment(Environment*) noexcept;
     Environment(Environment&&) = default;
 
@@ -41,11 +59,43 @@ class EnvTree {
 
     Environment& operator=(Environment&&) = default;
 
-    StackElement* lookup(const std::string&);
+    // Gets the binding of the name in this environment or the nearest one
+    // enclosing it, or nullptr. Loads the module defining the name if needed.
+    const Value* find(Symbol);
+    // As find, but reports a missing name to the user.
+    const Value& lookup(Symbol);
+    // Gets the binding of the name in this environment only, or nullptr.
+    const Value* get(Symbol) const noexcept;
     void clearBindings() noexcept;
 
+    // Includes the module registered to define the name, if it has not been
+    // loaded yet. Gives whether a module was included.
+    bool autoload(Symbol);
+    // Includes every module waiting to be autoloaded.
+    void autoloadAll();
+
+    // Must be called after define, undefine, or export changes the binding of
+    // the name in this environment.
+    void bindingChanged(Symbol) noexcept;
+    // Must be called after the modules or autoloads of the root change.
+    void modulesChanged() noexcept;
+
+    // Changes whenever a binding of the tree changes in a way that could
+    // affect where a global name is found, so cached lookups can tell when to
+    // be redone. Versions are never reused, even by other trees, so a cached
+    // lookup is never mistaken for one made in another tree.
+    size_t getVersion() const noexcept;
+    // As getVersion, but changes whenever any binding of the tree or the
+    // modules of the root change, so an image of the tree can tell when to be
+    // made again.
+    size_t getStamp() const noexcept;
+
    private:
     std::vector<Environment*> children;
+    size_t changes;   // version of the tree, if this is its root
+    size_t* version;  // the root's version
+    size_t* stamp;    // the root's stamp
+    size_t edits;     // stamp of the tree, if this is its root
   };
 
   EnvTree() noexcept;
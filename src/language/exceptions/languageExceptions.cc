@@ -90,13 +90,13 @@ SyntaxError::SyntaxError(const string& msg, const string& ctx, size_t pos,
 
 string SyntaxError::getKind() const noexcept { return "Syntax error:"; }
 
-TypeError::TypeError(const StackElement& expected, const StackElement& given,
+TypeError::TypeError(const Value& expected, const Value& given,
                      vector<string> trace) noexcept
     : LanguageException("Expected " + static_cast<string>(expected) +
                             ", given " + static_cast<string>(given),
                         trace) {}
 
-TypeError::TypeError(const StackElement& expected,
+TypeError::TypeError(const Value& expected,
                      vector<string> trace) noexcept
     : LanguageException("Expected " + static_cast<string>(expected) +
                             " but reached the bottom of the stack instead.",
@@ -121,9 +121,9 @@ class SyntaxError : public LanguageException {
 
 class TypeError : public LanguageException {
  public:
-  TypeError(const StackElement&, const StackElement&,
+  TypeError(const Value&, const Value&,
             std::vector<std::string> = std::vector<std::string>{}) noexcept;
-  TypeError(const StackElement&,
+  TypeError(const Value&,
             std::vector<std::string> = std::vector<std::string>{}) noexcept;
   TypeError(const TypeError&) = default;
 
@@ -0,0 +1,461 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of environment images.
+
+#include "language/image.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "language/exceptions/languageExceptions.h"
+#include "language/language.h"
+#include "language/primitives.h"
+#include "language/serialization.h"
+#include "language/stack/stackElements.h"
+
+namespace stacklang {
+namespace {
+using exceptions::RuntimeError;
+using stackelements::CommandElement;
+using stackelements::DefinedCommandElement;
+using stackelements::PrimitiveCommandElement;
+using stackelements::SubstackElement;
+using std::find;
+using std::map;
+using std::memcmp;
+using std::ofstream;
+using std::set;
+using std::streamsize;
+using std::string;
+using std::string_view;
+using std::uint64_t;
+using std::vector;
+
+// changed whenever the format changes, so old images are not misread.
+const char MAGIC[] = "STI4";
+
+enum class CommandKind : unsigned char { Primitive, Defined };
+
+// The calls the entry sees when it is called from the scope, by the
+// environments of their commands.
+typedef map<const Environment*, const Frame*> Calls;
+
+Calls callsSeen(const Scope& scope, const Value& entry) {
+  Calls calls;
+  if (entry.getType() != StackElement::DataType::Command ||
+      static_cast<const CommandElement*>(entry.get())->isPrimitive()) {
+    return calls;
+  }
+
+  const Environment* env =
+      static_cast<const DefinedCommandElement*>(entry.get())->getEnv();
+  bool enclosing = false;
+  for (Scope curr = scope; !curr.isGlobal(); curr = curr.getParent()) {
+    // once one scope encloses the entry, so do the scopes enclosing it.
+    for (const Environment* encl = env->parent; !enclosing && encl != nullptr;
+         encl = encl->parent) {
+      enclosing = encl == curr.getEnv();
+    }
+    if (enclosing && curr.getCall() != nullptr) {
+      calls.emplace(curr.getEnv(), curr.getCall());
+    }
+  }
+  return calls;
+}
+
+Environment* rootOf(const Scope& scope) noexcept {
+  Environment* root = scope.getEnv();
+  while (root->parent != nullptr) root = root->parent;
+  return root;
+}
+
+// Environments are saved so that each comes after its parent and after the
+// commands used in the definition of the command that owns it, and are
+// referred to by their position. The root comes first.
+class ImageWriter : public Encoder {
+ public:
+  ImageWriter(Environment* root, const Value& entry, const Calls& c)
+      : calls{c} {
+    collectEnv(root);
+    if (entry) collect(entry);
+    order(root);
+    for (const auto& owner : owners) order(owner.first);
+
+    write(MAGIC);
+    write(static_cast<unsigned char>(sizeof(long double)));
+    writeSize(envs.size());
+    for (size_t i = 1; i < envs.size(); i++) {
+      Environment* env = envs[i];
+      writeSize(ids.at(env->parent));
+      const DefinedCommandElement* owner = owners.at(env);
+      write(static_cast<unsigned char>(owner != nullptr));
+      if (owner != nullptr) {
+        writeStack(owner->getParams());
+        writeStack(owner->getSig());
+        writeStack(owner->getBody());
+      } else {  // owner was undefined, but its parameters still shadow
+        writeSize(env->params.size());
+        for (Symbol param : env->params) writeString(param.getName());
+      }
+    }
+    for (Environment* env : envs) {
+      // a running command is saved as its call sees it, and its parameters
+      // shadow its definitions.
+      const Frame* call = callOf(env);
+      const Bindings& bindings =
+          call != nullptr ? call->bindings : env->bindings;
+      vector<const Value*> shadowed;
+      if (call != nullptr) {
+        for (Symbol param : env->params) {
+          const Value* binding = bindings.find(param);
+          if (binding != nullptr) shadowed.push_back(binding);
+        }
+      }
+      writeSize(bindings.size() - shadowed.size() +
+                (call != nullptr ? env->params.size() : 0));
+      for (const auto& binding : bindings) {
+        if (find(shadowed.begin(), shadowed.end(), &binding.second) !=
+            shadowed.end()) {
+          continue;
+        }
+        writeString(binding.first.getName());
+        writeValue(binding.second);
+      }
+      for (size_t i = 0; call != nullptr && i < env->params.size(); i++) {
+        writeString(env->params[i].getName());
+        writeValue(call->slots[i]);
+      }
+    }
+    writeSize(root->modules.size());
+    for (const auto& module : root->modules) {
+      writeString(module.first);
+      write(module.second);
+    }
+    writeSize(root->autoloads.size());
+    for (const auto& autoload : root->autoloads) {
+      writeString(autoload.first.getName());
+      writeString(autoload.second);
+    }
+    write(static_cast<unsigned char>(static_cast<bool>(entry)));
+    if (entry) writeValue(entry);
+  }
+
+ protected:
+  void writeCommand(const CommandElement& cmd) override {
+    if (cmd.isPrimitive()) {
+      write(CommandKind::Primitive);
+      size_t opcode =
+          static_cast<const PrimitiveCommandElement&>(cmd).getOpcode();
+      writeString(PRIMITIVES[opcode].name);
+    } else {
+      write(CommandKind::Defined);
+      const DefinedCommandElement& def =
+          static_cast<const DefinedCommandElement&>(cmd);
+      writeSize(ids.at(def.getEnv()));
+    }
+  }
+
+ private:
+  // Finds the environments and commands reachable from an environment.
+  void collectEnv(Environment* env) {
+    for (; env != nullptr && owners.find(env) == owners.end();
+         env = env->parent) {
+      owners.emplace(env, nullptr);
+      const Frame* call = callOf(env);
+      for (const auto& binding :
+           call != nullptr ? call->bindings : env->bindings) {
+        collect(binding.second);
+      }
+      for (size_t i = 0; call != nullptr && i < env->params.size(); i++) {
+        collect(call->slots[i]);
+      }
+    }
+  }
+  void collect(const Value& elm) {
+    if (elm.getType() == StackElement::DataType::Substack) {
+      for (const Value& item :
+           static_cast<const SubstackElement*>(elm.get())->getData()) {
+        collect(item);
+      }
+    } else if (elm.getType() == StackElement::DataType::Command &&
+               !static_cast<const CommandElement*>(elm.get())->isPrimitive()) {
+      const DefinedCommandElement* cmd =
+          static_cast<const DefinedCommandElement*>(elm.get());
+      collectEnv(cmd->getEnv());
+      const DefinedCommandElement*& owner = owners.at(cmd->getEnv());
+      if (owner == cmd) return;
+      owner = cmd;
+      for (const Stack* s : {&cmd->getParams(), &cmd->getSig(),
+                             &cmd->getBody()}) {
+        for (const Value& item : *s) collect(item);
+      }
+    }
+  }
+
+  // Gives environments their positions.
+  void order(Environment* env) {
+    if (ids.find(env) != ids.end()) return;
+    if (!visiting.insert(env).second) {
+      throw RuntimeError("Cannot save a command that contains itself.");
+    }
+
+    if (env->parent != nullptr) order(env->parent);
+    const DefinedCommandElement* owner = owners.at(env);
+    if (owner != nullptr) {
+      for (const Stack* s : {&owner->getParams(), &owner->getSig(),
+                             &owner->getBody()}) {
+        for (const Value& item : *s) orderUses(item);
+      }
+    }
+
+    ids.emplace(env, envs.size());
+    envs.push_back(env);
+  }
+  void orderUses(const Value& elm) {
+    if (elm.getType() == StackElement::DataType::Substack) {
+      for (const Value& item :
+           static_cast<const SubstackElement*>(elm.get())->getData()) {
+        orderUses(item);
+      }
+    } else if (elm.getType() == StackElement::DataType::Command &&
+               !static_cast<const CommandElement*>(elm.get())->isPrimitive()) {
+      order(static_cast<const DefinedCommandElement*>(elm.get())->getEnv());
+    }
+  }
+
+  const Frame* callOf(const Environment* env) const {
+    auto found = calls.find(env);
+    return found != calls.end() ? found->second : nullptr;
+  }
+
+  const Calls& calls;
+  map<Environment*, const DefinedCommandElement*> owners;
+  set<Environment*> visiting;
+  map<const Environment*, uint64_t> ids;
+  vector<Environment*> envs;
+};
+
+class ImageReader : public Decoder {
+ public:
+  ImageReader(string_view data, Environment* root) noexcept
+      : Decoder(data), envs{root}, commands(1) {}
+
+  // Gives false if the image is corrupt.
+  bool load(Value& entry) {
+    char magic[sizeof(MAGIC)];
+    unsigned char numberSize;
+    uint64_t count;
+    if (!read(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !read(numberSize) || numberSize != sizeof(long double) ||
+        !read(count) || count == 0) {
+      return false;
+    }
+
+    for (uint64_t i = 1; i < count; i++) {
+      uint64_t parent;
+      unsigned char hasOwner;
+      if (!read(parent) || parent >= i || !read(hasOwner)) return false;
+      Environment* env = new Environment(envs[parent]);  // owned by parent
+      envs.push_back(env);
+
+      if (hasOwner != 0) {
+        Stack params;
+        Stack sig;
+        Stack body;
+        if (!readStack(params) || !readStack(sig) || !readStack(body)) {
+          return false;
+        }
+        for (const Value& param : params) {
+          if (param.getType() != StackElement::DataType::Identifier) {
+            return false;
+          }
+        }
+        commands.emplace_back(
+            new DefinedCommandElement(params, sig, body, env));
+      } else {
+        uint64_t size;
+        if (!read(size)) return false;
+        for (uint64_t j = 0; j < size; j++) {
+          string param;
+          if (!readString(param)) return false;
+          env->params.emplace_back(param);
+        }
+        commands.emplace_back();
+      }
+    }
+
+    for (Environment* env : envs) {
+      uint64_t size;
+      if (!read(size)) return false;
+      for (uint64_t i = 0; i < size; i++) {
+        string name;
+        Value elm;
+        if (!readString(name) || !readValue(elm)) return false;
+        Symbol symbol(name);
+        env->bindings.assign(symbol, elm);
+        env->bindingChanged(symbol);
+      }
+    }
+
+    // so they are not included again.
+    if (!read(count)) return false;
+    for (uint64_t i = 0; i < count; i++) {
+      string module;
+      double seconds;
+      if (!readString(module) || !read(seconds)) return false;
+      envs[0]->modules.insert_or_assign(module, seconds);
+    }
+    if (!read(count)) return false;
+    for (uint64_t i = 0; i < count; i++) {
+      string name;
+      string module;
+      if (!readString(name) || !readString(module)) return false;
+      envs[0]->autoloads.insert_or_assign(Symbol(name), module);
+    }
+    envs[0]->modulesChanged();
+
+    unsigned char hasEntry;
+    if (!read(hasEntry) || (hasEntry != 0 && !readValue(entry))) return false;
+
+    return isDone();
+  }
+
+ protected:
+  bool readCommand(Value& elm) override {
+    CommandKind kind;
+    if (!read(kind)) return false;
+    if (kind == CommandKind::Primitive) {
+      string name;
+      if (!readString(name)) return false;
+      for (size_t opcode = 0; opcode < NUM_PRIMITIVES; opcode++) {
+        if (name == PRIMITIVES[opcode].name) {
+          elm = Value(new PrimitiveCommandElement(opcode));
+          return true;
+        }
+      }
+      return false;
+    } else if (kind == CommandKind::Defined) {
+      uint64_t id;
+      if (!read(id) || id >= commands.size() || !commands[id]) return false;
+      elm = commands[id];
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+ private:
+  vector<Environment*> envs;  // by position in the image
+  vector<Value> commands;     // owning each environment, if any
+};
+
+// A whole file mapped read-only into memory.
+class MappedFile {
+ public:
+  explicit MappedFile(const string& path) : data{nullptr}, size{0} {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) throw RuntimeError("Could not open image " + path + ".");
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size <= 0) {
+      close(fd);
+      throw RuntimeError("Could not read image " + path + ".");
+    }
+    size = static_cast<size_t>(info.st_size);
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping stays valid
+    if (data == MAP_FAILED) {
+      throw RuntimeError("Could not read image " + path + ".");
+    }
+  }
+  MappedFile(const MappedFile&) = delete;
+
+  ~MappedFile() noexcept { munmap(data, size); }
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  string_view getData() const noexcept {
+    return string_view(static_cast<const char*>(data), size);
+  }
+
+ private:
+  void* data;
+  size_t size;
+};
+}  // namespace
+
+void saveImage(const string& path, Environment* root) {
+  // modules not loaded yet are saved as if they were, since the image may be
+  // loaded where they cannot be found.
+  root->autoloadAll();
+
+  string image = encodeImage(root);
+  ofstream fout(path, ofstream::binary | ofstream::trunc);
+  if (!fout.is_open()) {
+    throw RuntimeError("Could not open image " + path + " for writing.");
+  }
+  fout.write(image.data(), static_cast<streamsize>(image.length()));
+  if (!fout) throw RuntimeError("Could not write image " + path + ".");
+}
+
+void loadImage(const string& path, Environment* root) {
+  MappedFile file(path);
+  Value entry;
+  if (!ImageReader(file.getData(), root).load(entry)) {
+    throw RuntimeError("Image " + path + " is corrupt.");
+  }
+}
+
+string encodeImage(const Scope& scope, const Value& entry) {
+  return ImageWriter(rootOf(scope), entry, callsSeen(scope, entry))
+      .getBuffer();
+}
+
+const string& ImageCache::encode(const Scope& scope, const Value& entry) {
+  Environment* root = rootOf(scope);
+  Calls calls = callsSeen(scope, entry);
+  if (calls.empty() && stamp == root->getStamp() && entry == cachedEntry) {
+    return image;
+  }
+
+  image = ImageWriter(root, entry, calls).getBuffer();
+  stamp = calls.empty() ? root->getStamp() : 0;
+  cachedEntry = entry;
+  return image;
+}
+
+Value decodeImage(string_view data, Environment* root) {
+  Value entry;
+  if (!ImageReader(data, root).load(entry)) {
+    throw RuntimeError("Image is corrupt.");
+  }
+  return entry;
+}
+}  // namespace stacklang
@@ -0,0 +1,70 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Snapshots of the global environment, for fast startup.
+
+#ifndef STACKLANG_LANGUAGE_IMAGE_H_
+#define STACKLANG_LANGUAGE_IMAGE_H_
+
+#include <string>
+#include <string_view>
+
+#include "language/environment.h"
+#include "language/language.h"
+#include "language/stack/stack.h"
+
+namespace stacklang {
+// Saves the bindings of the root environment to an image file, along with
+// every defined command reachable from them and the environments those
+// commands are closed over. Modules not loaded yet are loaded first. Throws
+// RuntimeError if the image cannot be written.
+void saveImage(const std::string& path, Environment* root);
+
+// Adds the bindings saved in an image to a new root environment, recreating
+// the saved commands and environments. The image is mapped into memory and
+// decoded in place. Throws RuntimeError if it cannot be read or is corrupt.
+void loadImage(const std::string& path, Environment* root);
+
+// As saveImage and loadImage, but with the image held in memory, so each
+// thread can be given its own copy of the tree of a scope. An entry value
+// saved with the image may refer to its commands, and is given back when
+// decoding. The parameters and definitions of the calls the entry would see if
+// called from the scope are saved as definitions of their environments.
+// Modules not loaded yet stay that way, and are loaded by the decoded
+// environment if it uses them. decodeImage throws RuntimeError if the data is
+// corrupt.
+std::string encodeImage(const Scope&, const Value& entry = Value());
+Value decodeImage(std::string_view data, Environment* root);
+
+// Keeps the last image encoded, and gives it again for the same tree and entry
+// while the tree has not changed. Images that saved calls are made again each
+// time, since those change from call to call.
+class ImageCache {
+ public:
+  ImageCache() noexcept : stamp{0} {}
+
+  const std::string& encode(const Scope&, const Value& entry);
+
+ private:
+  size_t stamp;  // of the environment when the image was made, or zero
+  Value cachedEntry;
+  std::string image;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_IMAGE_H_
@@ -0,0 +1,104 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of interpreter contexts.
+
+#include "language/interpreter.h"
+
+#include "language/exceptions/interpreterExceptions.h"
+#include "language/exceptions/languageExceptions.h"
+#include "language/image.h"
+#include "language/language.h"
+#include "language/sourceReader.h"
+#include "language/stack/stackElements.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace stacklang {
+namespace {
+using exceptions::ParserException;
+using exceptions::RuntimeError;
+using stackelements::IdentifierElement;
+using stackelements::StringElement;
+using std::ifstream;
+using std::istringstream;
+using std::string;
+using std::string_view;
+using std::to_string;
+}  // namespace
+
+Interpreter::Interpreter() noexcept : stopping{false} {}
+
+Interpreter::Interpreter(string_view image) : stopping{false} {
+  decodeImage(image, tree.getRoot());
+}
+
+Stack& Interpreter::getStack() noexcept { return s; }
+
+Environment* Interpreter::getRoot() noexcept { return tree.getRoot(); }
+
+void Interpreter::run(const Value& elm) {
+  ExecutionScope scope(stopping, &arena, &cache);
+  s.push(elm);
+  execute(s, tree.getRoot());
+}
+
+void Interpreter::include(const string& path) {
+  s.push(new StringElement(path));
+  run(new IdentifierElement("include"));
+}
+
+void Interpreter::eval(string_view text) {
+  istringstream in{string(text)};
+  SourceReader source(in, "input");
+  string_view element;
+  size_t line;
+  while (source.next(element, line)) {
+    run(StackElement::parse(string(element)));
+  }
+}
+
+void Interpreter::runFile(const string& path) {
+  ifstream fin(path);
+  if (!fin.is_open()) throw RuntimeError("Could not open " + path + ".");
+  SourceReader source(fin, path);
+  fin.close();
+
+  string_view element;
+  size_t line;
+  while (source.next(element, line)) {
+    Value elm;
+    try {
+      elm = StackElement::parse(string(element));
+    } catch (const ParserException& exn) {  // located as include does
+      throw ParserException(
+          path + ":" + to_string(line) + ": " + exn.getMessage(),
+          exn.getContext(), exn.getLocation());
+    }
+    run(elm);
+  }
+}
+
+string Interpreter::makeImage() {
+  ExecutionScope scope(stopping, &arena, &cache);  // modules may be autoloaded
+  return encodeImage(tree.getRoot());
+}
+
+void Interpreter::stop() noexcept { stopping = true; }
+}  // namespace stacklang
@@ -0,0 +1,87 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// A self-contained interpreter, for running many programs in one process.
+
+#ifndef STACKLANG_LANGUAGE_INTERPRETER_H_
+#define STACKLANG_LANGUAGE_INTERPRETER_H_
+
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#include "language/bytecode.h"
+#include "language/environment.h"
+#include "language/slotArena.h"
+#include "language/stack/stack.h"
+
+namespace stacklang {
+// A stack and environment tree, along with the stop flag, parameter storage
+// and lookup cache used to run them. Contexts only share data that never
+// changes once made - the primitive table, interned names, and the compiled
+// bodies of commands - so each thread may run a context of its own at the
+// same time as the others.
+//
+// A context must only be used by one thread at a time. Values taken from one
+// context must not be given to another, since substacks share buffers that
+// are appended to in place, and commands look names up in the tree they were
+// defined in - pass them as text or in an image instead.
+class Interpreter {
+ public:
+  // Starts with only the primitives defined.
+  Interpreter() noexcept;
+  // Starts from the definitions in an image made by makeImage. Throws
+  // RuntimeError if the image is corrupt.
+  explicit Interpreter(std::string_view image);
+  Interpreter(const Interpreter&) = delete;
+
+  ~Interpreter() noexcept = default;
+
+  Interpreter& operator=(const Interpreter&) = delete;
+
+  Stack& getStack() noexcept;
+  Environment* getRoot() noexcept;
+
+  // Pushes the element, and executes the stack until data is on top.
+  void run(const Value&);
+  // Includes a library, as the include primitive does.
+  void include(const std::string& path);
+  // Parses each top level element of the text, and runs it, as if the text
+  // were an included file.
+  void eval(std::string_view text);
+  // Runs the file as include does, but without caching its parsed elements
+  // or recording it as a module. Throws RuntimeError if it cannot be read.
+  void runFile(const std::string& path);
+
+  // Saves the definitions, to start other contexts from.
+  std::string makeImage();
+
+  // Makes the running evaluation (or the next one) throw StopError. May be
+  // called from any thread.
+  void stop() noexcept;
+
+ private:
+  EnvTree tree;
+  Stack s;
+  std::atomic_bool stopping;
+  SlotArena arena;
+  LookupCache cache;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_INTERPRETER_H_
@@ -20,12 +20,21 @@
 
 #include "language/language.h"
 
+#include "language/bytecode.h"
 #include "language/exceptions/languageExceptions.h"
+#include "language/primitives.h"
+#include "language/slotArena.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace stacklang {
 namespace {
+using exceptions::RuntimeError;
 using exceptions::StopError;
 using exceptions::SyntaxError;
 using exceptions::TypeError;
@@ -35,93 +44,320 @@ using stackelements::DefinedCommandPtr;
 using stackelements::IdentifierElement;
 using stackelements::IdentifierPtr;
 using stackelements::PrimitiveCommandElement;
-using stackelements::PrimitiveCommandPtr;
 using stackelements::SubstackElement;
 using stackelements::TypeElement;
 using std::all_of;
 using std::atomic_bool;
+using std::deque;
+using std::max;
 using std::string;
+using std::thread;
+using std::vector;
 }  // namespace
 
 atomic_bool stopFlag = false;
 
-bool checkType(const StackElement* elm, const TypeElement& type) {
-  if (elm == nullptr) {  // nullptr not matched ever.
+size_t numWorkers = max(thread::hardware_concurrency(), 1u);
+
+namespace {
+// Checks an element against a type given as a base and a specialization.
+bool checkType(const Value& elm, StackElement::DataType base,
+               const TypeElement* spec) {
+  if (!elm) {  // empty values not matched ever.
     return false;
-  } else if (type.getBase() == StackElement::DataType::Any &&
-             type.getSpecialization() ==
-                 nullptr) {  // any matches everything not null
+  } else if (base == StackElement::DataType::Any &&
+             spec == nullptr) {  // any matches everything not null
     return true;
-  } else if (type.getBase() != elm->getType()) {  // types don't match plainly
+  } else if (base != elm.getType()) {  // types don't match plainly
     return false;
-  } else if (elm->getType() ==
+  } else if (elm.getType() ==
              StackElement::DataType::Identifier) {  // identifier special case
-    return dynamic_cast<const IdentifierElement*>(elm)->isQuoted();
-  } else if (type.getSpecialization() == nullptr ||
-             type.getSpecialization()->getBase() ==
+    return dynamic_cast<const IdentifierElement*>(elm.get())->isQuoted();
+  } else if (spec == nullptr ||
+             spec->getBase() ==
                  StackElement::DataType::Any) {  // has no specialization or is
                                                  // an Any specialized substack.
     return true;                                 // type matches plainly
-  } else if (elm->getType() == type.getBase() &&
-             type.getBase() ==
-                 StackElement::DataType::Substack) {  // is a specialized
-                                                      // substack
-    const Stack& s = dynamic_cast<const SubstackElement*>(elm)->getData();
-    const TypeElement* spec = type.getSpecialization();
-
-    return all_of(s.begin(), s.end(), [&spec](const StackElement* e) {
-      return checkType(e, *spec);
+  } else if (base == StackElement::DataType::Substack) {  // is a specialized
+                                                         // substack
+    const Stack& s = dynamic_cast<const SubstackElement*>(elm.get())->getData();
+
+    return all_of(s.begin(), s.end(), [&spec](const Value& e) {
+      return checkType(e, spec->getBase(), spec->getSpecialization());
     });
-  } else if (elm->getType() == type.getBase() &&
-             type.getBase() ==
-                 StackElement::DataType::Command) {  // is a specialized command
-    return (type.getSpecialization()->getBase() ==
-            StackElement::DataType::Primitive) ==
-           dynamic_cast<const CommandElement*>(elm)->isPrimitive();
+  } else if (base ==
+             StackElement::DataType::Command) {  // is a specialized command
+    return (spec->getBase() == StackElement::DataType::Primitive) ==
+           dynamic_cast<const CommandElement*>(elm.get())->isPrimitive();
   } else {  // is a specialized non-substack
-    throw SyntaxError("Impossible type detected.", static_cast<string>(type),
+    throw SyntaxError("Impossible type detected.",
+                      TypeElement::to_string(base) + "(" +
+                          static_cast<string>(*spec) + ")",
                       0);
   }
 }
 
+// Gets the base type of a type tag, and the base type of its specialization.
+StackElement::DataType baseOf(TypeTag type) noexcept {
+  return static_cast<StackElement::DataType>(type & 0xff);
+}
+StackElement::DataType specializationOf(TypeTag type) noexcept {
+  return static_cast<StackElement::DataType>((type >> 8) - 1);
+}
+
+// Checks an element against a type given as a type tag.
+bool checkType(const Value& elm, TypeTag type) {
+  StackElement::DataType base = baseOf(type);
+  if (type == typeTag(base)) {  // no specialization - checked plainly
+    return elm && (base == StackElement::DataType::Any ||
+                   (base == elm.getType() &&
+                    (base != StackElement::DataType::Identifier ||
+                     static_cast<const IdentifierElement*>(elm.get())
+                         ->isQuoted())));
+  } else if (!elm || base != elm.getType()) {
+    return false;
+  } else if (base == StackElement::DataType::Substack) {
+    const Stack& s = static_cast<const SubstackElement*>(elm.get())->getData();
+    return all_of(s.begin(), s.end(), [&type](const Value& e) {
+      return checkType(e, typeTag(specializationOf(type)));
+    });
+  } else {
+    return (specializationOf(type) == StackElement::DataType::Primitive) ==
+           static_cast<const CommandElement*>(elm.get())->isPrimitive();
+  }
+}
+
+// Makes the type element a type tag stands for, to report errors with.
+Value toType(TypeTag type) {
+  StackElement::DataType base = baseOf(type);
+  if (type == typeTag(base)) return Value(base);
+  return Value(new TypeElement(base, new TypeElement(specializationOf(type))));
+}
+
+// What execute uses on this thread, unless an ExecutionScope says otherwise.
+thread_local SlotArena threadArena;
+thread_local LookupCache threadCache;
+thread_local atomic_bool* currentStop = nullptr;
+thread_local SlotArena* currentArena = nullptr;
+thread_local LookupCache* currentCache = nullptr;
+
+// A frame, and where to release its slots from when it returns.
+struct Call : Frame {
+  SlotArena::Mark mark;
+};
+
+// The calls being run by one execute, innermost last. Unwinding returns from
+// all of them.
+class CallStack {
+ public:
+  CallStack(SlotArena& a, LookupCache& c) noexcept
+      : arena{a}, cache{c}, depth{0}, innermost{nullptr} {}
+  CallStack(const CallStack&) = delete;
+
+  ~CallStack() noexcept {
+    while (depth > 0) leave();
+  }
+
+  CallStack& operator=(const CallStack&) = delete;
+
+  bool isEmpty() const noexcept { return depth == 0; }
+  Frame& top() noexcept { return *innermost; }
+  // Gets the scope the innermost call runs in, or the scope given if there
+  // are no calls.
+  Scope getScope(const Scope& base) noexcept {
+    return depth == 0 ? base : Scope(innermost->cmd->getEnv(), innermost);
+  }
+
+  // Pops the arguments of the command into a new frame, enclosed by the
+  // call given.
+  void enter(const DefinedCommandPtr& cmd, Stack& s, Frame* outer) {
+    SlotArena::Mark mark = arena.mark();
+    Value* slots = arena.allocate(cmd->getEnv()->params.size());
+    try {
+      cmd->bind(s, slots);
+      if (depth == frames.size()) frames.emplace_back();
+    } catch (...) {
+      arena.release(mark);
+      throw;
+    }
+
+    innermost = &frames[depth++];
+    innermost->cmd = cmd;
+    innermost->pc = 0;
+    innermost->slots = slots;
+    innermost->outer = outer;
+    innermost->id = cache.nextCall();
+    innermost->mark = mark;
+  }
+
+  void leave() noexcept {
+    arena.release(innermost->mark);
+    innermost->cmd = nullptr;
+    innermost->bindings.clear();
+    innermost = --depth > 0 ? &frames[depth - 1] : nullptr;
+  }
+
+ private:
+  SlotArena& arena;
+  LookupCache& cache;
+  // frames are kept for the calls that come after, and never moved, since
+  // they are pointed to.
+  deque<Call> frames;
+  size_t depth;
+  Call* innermost;
+};
+
+// Finds the call a command called from the scope runs in: the call of the
+// nearest command enclosing it that the scope can see, if any.
+Frame* outerOf(const DefinedCommandPtr& cmd, const Scope& caller) noexcept {
+  Environment* env = cmd->getEnv();
+  if (env->parent->parent == nullptr) return nullptr;  // defined globally
+
+  for (Scope curr = caller; !curr.isGlobal(); curr = curr.getParent()) {
+    if (curr.getCall() == nullptr) continue;
+    for (Environment* encl = env->parent; encl != nullptr;
+         encl = encl->parent) {
+      if (encl == curr.getEnv()) return curr.getCall();
+    }
+  }
+  return nullptr;
+}
+
+// Checks if a command can replace the frame calling it. The frame must have
+// nothing left to run, and the command must not be able to see the frame's
+// bindings.
+bool isTailCall(const Frame& caller, const DefinedCommandPtr& callee) {
+  if (caller.pc != caller.cmd->getCode().size()) return false;
+
+  Environment* env = caller.cmd->getEnv();
+  for (Environment* curr = callee->getEnv()->parent; curr != nullptr;
+       curr = curr->parent) {
+    if (curr == env) return false;
+  }
+  return true;
+}
+}  // namespace
+
+bool checkType(const Value& elm, const Value& type) {
+  return checkType(elm, type.getBase(), type.getSpecialization());
+}
+
 void checkTypes(const Stack& s, const Stack& types) {
   auto typeIter = types.begin();
   auto stackIter = s.begin();
 
   for (; typeIter != types.end() && stackIter != s.end();
        typeIter++, stackIter++) {
-    if (!checkType(*stackIter, *static_cast<const TypeElement*>(*typeIter))) {
-      throw TypeError(**typeIter, **stackIter);
+    if (!checkType(*stackIter, *typeIter)) {
+      throw TypeError(*typeIter, *stackIter);
     }
   }
   if (typeIter != types.end()) {
-    throw TypeError(**typeIter);
+    throw TypeError(*typeIter);
   }
 }
 
-void execute(Stack& s, Environment* env) {
-  if (stopFlag) {
-    stopFlag = false;
-    throw StopError();
+void checkTypes(const Stack& s, const TypeTag* types, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    TypeTag type = types[count - 1 - i];
+    if (i >= s.size()) throw TypeError(toType(type));
+    if (!checkType(s[i], type)) throw TypeError(toType(type), s[i]);
+  }
+}
+
+const Value* Scope::get(Symbol id) const noexcept {
+  if (call != nullptr) {
+    const vector<Symbol>& params = env->params;
+    for (size_t i = 0; i < params.size(); i++) {
+      if (params[i] == id) return &call->slots[i];
+    }
+  }
+
+  return getBindings().find(id);
+}
+
+const Value* Scope::find(Symbol id) const {
+  for (Scope curr = *this;; curr = curr.getParent()) {
+    const Value* binding = curr.get(id);
+    if (binding != nullptr) return binding;
+    if (curr.isGlobal()) break;
   }
-  if (s.isEmpty()) return;
-
-  if (s.top()->getType() == StackElement::DataType::Identifier &&
-      !dynamic_cast<const IdentifierElement*>(s.top())
-           ->isQuoted()) {  // identifier that isn't quoted.
-    IdentifierPtr id(dynamic_cast<IdentifierElement*>(s.pop()));
-    s.push(env->lookup(id->getName()));
-    return execute(s, env);
-  } else if (s.top()->getType() == StackElement::DataType::Command) {
-    const CommandElement* cmd = dynamic_cast<const CommandElement*>(s.top());
-    if (cmd->isPrimitive()) {
-      PrimitiveCommandPtr prim(dynamic_cast<PrimitiveCommandElement*>(s.pop()));
-      (*prim)(s, env);
+
+  return env->autoload(id) ? find(id) : nullptr;
+}
+
+const Value& Scope::lookup(Symbol id) const {
+  const Value* binding = find(id);
+  if (binding == nullptr) {
+    throw RuntimeError("Cannot find identifier '" + id.getName() + "'.");
+  }
+  return *binding;
+}
+
+ExecutionScope::ExecutionScope(atomic_bool& stop, SlotArena* arena,
+                               LookupCache* cache) noexcept
+    : savedStop{currentStop},
+      savedArena{currentArena},
+      savedCache{currentCache} {
+  currentStop = &stop;
+  if (arena != nullptr) currentArena = arena;
+  if (cache != nullptr) currentCache = cache;
+}
+
+ExecutionScope::~ExecutionScope() noexcept {
+  currentStop = savedStop;
+  currentArena = savedArena;
+  currentCache = savedCache;
+}
+
+atomic_bool& currentStopFlag() noexcept {
+  return currentStop != nullptr ? *currentStop : stopFlag;
+}
+
+void execute(Stack& s, const Scope& scope) {
+  atomic_bool& stop = currentStopFlag();
+  LookupCache& cache = currentCache != nullptr ? *currentCache : threadCache;
+  CallStack calls(currentArena != nullptr ? *currentArena : threadArena,
+                  cache);
+
+  Scope curr = scope;
+  while (true) {
+    if (stop) {
+      stop = false;
+      throw StopError();
+    }
+
+    if (!s.isEmpty() &&
+        s.top().getType() == StackElement::DataType::Identifier &&
+        !static_cast<const IdentifierElement*>(s.top().get())
+             ->isQuoted()) {  // identifier that isn't quoted.
+      IdentifierPtr id(s.pop());
+      s.push(curr.lookup(id->getSymbol()));
+    } else if (!s.isEmpty() &&
+               s.top().getType() == StackElement::DataType::Command) {
+      const CommandElement* cmd =
+          static_cast<const CommandElement*>(s.top().get());
+      if (cmd->isPrimitive()) {
+        size_t opcode =
+            static_cast<const PrimitiveCommandElement*>(cmd)->getOpcode();
+        s.drop();
+        PRIMITIVES[opcode].fun(s, curr);
+      } else {
+        DefinedCommandPtr func(s.pop());
+        Frame* outer = outerOf(func, curr);
+        if (!calls.isEmpty() && isTailCall(calls.top(), func)) calls.leave();
+        calls.enter(func, s, outer);
+        curr = calls.getScope(scope);
+      }
+    } else if (calls.isEmpty()) {  // data on top, and nothing left to run
+      return;
+    } else if (calls.top().pc == calls.top().cmd->getCode().size()) {
+      calls.leave();
+      curr = calls.getScope(scope);
     } else {
-      DefinedCommandPtr func(dynamic_cast<DefinedCommandElement*>(s.pop()));
-      (*func)(s);
+      Frame& frame = calls.top();
+      frame.cmd->getCode().run(frame.pc++, s, curr, cache);
     }
-    return execute(s, env);
   }
 }
 }  // namespace stacklang
@@ -27,18 +27,131 @@
 #include <utility>
 #include <vector>
 
+#include "language/bindings.h"
 #include "language/environment.h"
 #include "language/stack/stack.h"
 #include "language/stack/stackElements.h"
 
 namespace stacklang {
-bool checkType(const StackElement* elm, const stackelements::TypeElement& type);
+class LookupCache;
+class SlotArena;
+
+// A type in a signature known at compile time, packed into an integer so
+// signatures can be template arguments. The low byte is the base type, and
+// the next byte is one more than the base type of its specialization, or zero
+// if it has none.
+typedef unsigned TypeTag;
+
+constexpr TypeTag typeTag(StackElement::DataType base) noexcept {
+  return static_cast<TypeTag>(base);
+}
+constexpr TypeTag typeTag(StackElement::DataType base,
+                          StackElement::DataType spec) noexcept {
+  return static_cast<TypeTag>(base) | (static_cast<TypeTag>(spec) + 1) << 8;
+}
+constexpr TypeTag typeTag(TypeTag tag) noexcept { return tag; }
+
+bool checkType(const Value& elm, const Value& type);
 void checkTypes(const Stack& s, const Stack& types);
-void execute(Stack&, Environment*);  // Executes the stack until it
+void checkTypes(const Stack& s, const TypeTag* types, size_t count);
+
+// Checks the stack against a signature given as data types or type tags,
+// listed from the deepest to the top, as in a Stack initializer.
+template <auto... Types>
+void checkTypes(const Stack& s) {
+  static constexpr TypeTag signature[] = {typeTag(Types)...};
+  checkTypes(s, signature, sizeof...(Types));
+}
+
+// A running call of a defined command. Its parameters and definitions are
+// kept here, not in the command or its environment, so running a command
+// never changes it, and recursive calls never disturb each other.
+struct Frame {
+  stackelements::DefinedCommandPtr cmd;  // keeps the command alive while it
+                                         // runs
+  size_t pc;                             // next instruction of its body
+  Value* slots;                          // its parameters
+  Bindings bindings;                     // what it has defined
+  Frame* outer;  // call of the nearest enclosing command seen by the caller,
+                 // if any
+  size_t id;     // unique among the calls using a LookupCache
+};
+
+// Where an element is run: an environment, and the running call of its
+// command - or failing that, of the nearest enclosing command - if any. The
+// enclosing scopes are found through the calls' outer frames. Environments
+// whose commands are not running there only have the definitions they were
+// made with.
+class Scope {
+ public:
+  // An environment nothing is running in, such as the root.
+  Scope(Environment* e) noexcept : env{e}, frame{nullptr}, call{nullptr} {}
+  Scope(Environment* e, Frame* f) noexcept
+      : env{e},
+        frame{f},
+        call{f != nullptr && f->cmd->getEnv() == e ? f : nullptr} {}
+
+  Environment* getEnv() const noexcept { return env; }
+  bool isGlobal() const noexcept { return env->parent == nullptr; }
+  // Gets the running call of the environment's command, or nullptr.
+  Frame* getCall() const noexcept { return call; }
+  // Gets the innermost call seen from here, or nullptr.
+  Frame* getFrame() const noexcept { return frame; }
+  // Gets the scope enclosing this one, which must not be global.
+  Scope getParent() const noexcept {
+    return Scope(env->parent, call != nullptr ? call->outer : frame);
+  }
+  // Gets the parameters of the running call, or nullptr.
+  Value* getSlots() const noexcept {
+    return call != nullptr ? call->slots : nullptr;
+  }
+  // Gets what the running call has defined, or the definitions of the
+  // environment if none is running.
+  Bindings& getBindings() const noexcept {
+    return call != nullptr ? call->bindings : env->bindings;
+  }
+
+  // As the methods of Environment, but seeing running calls.
+  const Value* find(Symbol) const;
+  const Value& lookup(Symbol) const;
+  const Value* get(Symbol) const noexcept;
+
+ private:
+  Environment* env;
+  Frame* frame;
+  Frame* call;  // frame, if it is a call of the environment's command
+};
+
+void execute(Stack&, const Scope&);  // Executes the stack until it
                                      // encounters a data element
 
 extern std::atomic_bool
     stopFlag;  // signal handlers set this to stop execution.
+
+// Makes execute on this thread check the stop flag given, and keep parameters
+// in the arena and global lookups in the cache given (if any), instead of
+// using stopFlag and an arena and cache of the thread's own. Lasts until
+// destroyed. Scopes nest.
+class ExecutionScope {
+ public:
+  explicit ExecutionScope(std::atomic_bool& stop, SlotArena* arena = nullptr,
+                          LookupCache* cache = nullptr) noexcept;
+  ExecutionScope(const ExecutionScope&) = delete;
+
+  ~ExecutionScope() noexcept;
+
+  ExecutionScope& operator=(const ExecutionScope&) = delete;
+
+ private:
+  std::atomic_bool* savedStop;
+  SlotArena* savedArena;
+  LookupCache* savedCache;
+};
+
+// The stop flag execute checks on this thread.
+std::atomic_bool& currentStopFlag() noexcept;
+
+extern size_t numWorkers;  // threads parallel primitives may use.
 }  // namespace stacklang
 
 #endif  // STACKLANG_LANGUAGE_
@@ -0,0 +1,371 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// primitive command table
+
+#define _USE_MATH_DEFINES
+
+#include "language/primitives.h"
+
+#include "language/exceptions/interpreterExceptions.h"
+#include "language/exceptions/languageExceptions.h"
+#include "language/image.h"
+#include "language/language.h"
+#include "language/serialization.h"
+#include "language/sourceCache.h"
+#include "language/sourceReader.h"
+#include "language/stack/lexer.h"
+#include "language/stack/stackElements.h"
+#include "util/mathUtils.h"
+#include "util/stringUtils.h"
+#include "util/workPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+
+// body is variadic, since template arguments in it have unparenthesized commas
+#define PRIMDEF(name, ...) {name, [](Stack & s, const Scope & e) __VA_ARGS__},
+
+namespace stacklang {
+namespace {
+using exceptions::RuntimeError;
+using stackelements::PrimitiveCommandElement;
+using stacklang::exceptions::ParserException;
+using stacklang::exceptions::RuntimeError;
+using stacklang::exceptions::StackOverflowError;
+using stacklang::exceptions::StackUnderflowError;
+using stacklang::exceptions::StopError;
+using stacklang::exceptions::SyntaxError;
+using stacklang::exceptions::TypeError;
+using stacklang::stackelements::BooleanElement;
+using stacklang::stackelements::BooleanPtr;
+using stacklang::stackelements::CommandElement;
+using stacklang::stackelements::CommandPtr;
+using stacklang::stackelements::DefinedCommandElement;
+using stacklang::stackelements::DefinedCommandPtr;
+using stacklang::stackelements::IdentifierElement;
+using stacklang::stackelements::IdentifierPtr;
+using stacklang::stackelements::NumberElement;
+using stacklang::stackelements::NumberPtr;
+using stacklang::stackelements::PrimitiveCommandElement;
+using stacklang::stackelements::PrimitiveCommandPtr;
+using stacklang::stackelements::StringElement;
+using stacklang::stackelements::StringPtr;
+using stacklang::stackelements::SubstackElement;
+using stacklang::stackelements::SubstackPtr;
+using stacklang::stackelements::TypeElement;
+using stacklang::stackelements::TypePtr;
+using std::abs;
+using std::acosh;
+using std::all_of;
+using std::asinh;
+using std::atanh;
+using std::begin;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+using std::copysign;
+using std::cos;
+using std::cosh;
+using std::end;
+using std::find_if;
+using std::atomic;
+using std::atomic_bool;
+using std::current_exception;
+using std::error_code;
+using std::exception_ptr;
+using std::ifstream;
+using std::isnan;
+using std::istringstream;
+using std::log;
+using std::make_unique;
+using std::map;
+using std::max;
+using std::min;
+using std::modf;
+using std::move;
+using std::pair;
+using std::pow;
+using std::random_device;
+using std::rethrow_exception;
+using std::sin;
+using std::sinh;
+using std::string;
+using std::string_view;
+using std::tan;
+using std::tanh;
+using std::to_string;
+using std::unique_ptr;
+using std::vector;
+using std::filesystem::weakly_canonical;
+using util::ends_with;
+using util::spaceship;
+using util::starts_with;
+using util::WorkPool;
+
+// Opens the file an include path names, looking in the libs folder for plain
+// filenames. Gives the name of the file opened.
+string openSource(const string& path, ifstream& fin) {
+  // change this to be more portable.
+  vector<string> candidates{path, path + ".sta"};
+  if (path.find('/') == string::npos) {
+    candidates.push_back("libs/" + path);
+    candidates.push_back("libs/" + path + ".sta");
+  }
+  for (const string& candidate : candidates) {
+    fin.open(candidate);
+    if (fin.is_open()) return candidate;
+  }
+  throw RuntimeError("Could not open include file " + path + ".");
+}
+
+// Gives the name modules are registered under for the file opened.
+string canonicalPath(const string& file) {
+  error_code err;
+  string canonical = weakly_canonical(file, err).string();
+  return err ? file : canonical;
+}
+
+Environment* rootOf(const Scope& e) noexcept {
+  Environment* root = e.getEnv();
+  while (root->parent != nullptr) root = root->parent;
+  return root;
+}
+
+// Gets the defined command the identifier is bound to.
+const DefinedCommandElement* definitionOf(const IdentifierElement& id,
+                                          const Scope& e) {
+  const Value& elm = e.lookup(id.getSymbol());
+  if (elm.getType() != StackElement::DataType::Command ||
+      static_cast<const CommandElement*>(elm.get())->isPrimitive()) {
+    throw RuntimeError("Identifier " + id.getName() +
+                       " is bound to a primitive command.");
+  }
+  return static_cast<const DefinedCommandElement*>(elm.get());
+}
+
+// Gets what to push to call the command given to a higher-order primitive,
+// which may be a command or a quoted identifier naming one.
+Value callable(const Value& fn) {
+  if (fn.getType() == StackElement::DataType::Command) {
+    return fn;
+  } else if (fn.getType() == StackElement::DataType::Identifier &&
+             static_cast<const IdentifierElement*>(fn.get())->isQuoted()) {
+    return Value(new IdentifierElement(
+        static_cast<const IdentifierElement*>(fn.get())->getSymbol()));
+  } else {
+    throw TypeError(Value(StackElement::DataType::Command), fn);
+  }
+}
+
+// Calls the command on the element, giving what it leaves on top.
+Value apply(Stack& s, const Scope& e, const Value& fn, const Value& elm) {
+  s.push(elm);
+  s.push(fn);
+  execute(s, e);
+  return s.pop();
+}
+
+// The pool parallel primitives run on, made when first used.
+WorkPool& workers() {
+  static WorkPool pool(numWorkers);
+  return pool;
+}
+
+// The last image workers were started from on this thread, since a program
+// often maps in parallel many times without changing its definitions.
+thread_local ImageCache workerImage;
+
+// A copy of an environment for a worker to run in.
+struct WorkerContext {
+  EnvTree tree;
+  Value fn;
+  Stack s;
+};
+
+// Maps the command over the elements on the pool's workers, in chunks. The
+// command is run on its own stack in copies of the environment made from an
+// image, so its definitions are not kept. The error of the earliest chunk to
+// fail is the one reported, as if the elements were mapped in order. With one
+// worker, or inside a task of the pool, the chunks run on this thread, but
+// still in a copy, so results do not depend on the number of threads.
+Stack parallelMap(Stack& s, const Scope& e, const Value& fn,
+                  const Stack& data) {
+  WorkPool& pool = workers();
+  bool inThread = pool.size() == 1 || WorkPool::isWorker();
+
+  // names are looked up here, since they may not be bound globally.
+  const string& image = workerImage.encode(
+      e,
+      fn.getType() == StackElement::DataType::Identifier
+          ? e.lookup(
+                static_cast<const IdentifierElement*>(fn.get())->getSymbol())
+          : fn);
+
+  // a few chunks for each worker, so stealing can even out the work.
+  size_t numChunks = min(data.size(), inThread ? 1 : pool.size() * 8);
+  vector<string> inputs(numChunks);
+  try {
+    for (size_t chunk = 0; chunk < numChunks; chunk++) {
+      Encoder input;
+      for (size_t i = data.size() * chunk / numChunks;
+           i < data.size() * (chunk + 1) / numChunks; i++) {
+        input.writeValue(data[i]);
+      }
+      inputs[chunk] = input.getBuffer();
+    }
+  } catch (const RuntimeError&) {
+    throw RuntimeError("Cannot map a substack of commands in parallel.");
+  }
+
+  vector<unique_ptr<WorkerContext>> contexts(inThread ? 1 : pool.size());
+  vector<string> outputs(numChunks);
+  vector<exception_ptr> errors(numChunks);
+  atomic<size_t> firstFailure = numChunks;
+  atomic_bool stopped = false;
+  atomic_bool& stop = currentStopFlag();
+  auto task = [&](size_t worker, size_t chunk) {
+    if (chunk > firstFailure) return;
+    ExecutionScope scope(stop);  // stops with the caller
+    try {
+      if (!contexts[worker]) {
+        auto context = make_unique<WorkerContext>();
+        context->s.setLimit(s.getLimit());
+        context->fn = decodeImage(image, context->tree.getRoot());
+        contexts[worker] = move(context);
+      }
+      WorkerContext& context = *contexts[worker];
+      context.s.clear();  // of anything left by an error
+      Decoder input(inputs[chunk]);
+      Encoder output;
+      Value elm;
+      while (!input.isDone()) {
+        if (!input.readValue(elm)) throw RuntimeError("Chunk is corrupt.");
+        Value result =
+            apply(context.s, context.tree.getRoot(), context.fn, elm);
+        try {
+          output.writeValue(result);
+        } catch (const RuntimeError&) {
+          throw RuntimeError("Cannot return a command from a parallel map.");
+        }
+      }
+      outputs[chunk] = output.getBuffer();
+    } catch (const StopError&) {  // the others are stopped too
+      stopped = true;
+      stop = true;
+      firstFailure = 0;
+    } catch (...) {
+      errors[chunk] = current_exception();
+      size_t failure = firstFailure;
+      while (chunk < failure &&
+             !firstFailure.compare_exchange_weak(failure, chunk)) {
+      }
+    }
+  };
+  if (inThread) {
+    for (size_t chunk = 0; chunk < numChunks; chunk++) task(0, chunk);
+  } else {
+    pool.run(numChunks, task);
+  }
+
+  if (stopped) {
+    stop = false;
+    throw StopError();
+  }
+  if (firstFailure < numChunks) rethrow_exception(errors[firstFailure]);
+
+  Stack result;
+  result.reserve(data.size());
+  for (const string& chunk : outputs) {
+    Decoder output(chunk);
+    Value elm;
+    while (!output.isDone()) {
+      if (!output.readValue(elm)) throw RuntimeError("Chunk is corrupt.");
+      result.push(elm);
+    }
+  }
+  result.reverse();
+  return result;
+}
+
+// Parses an element read from the included file at the path, reporting
+// errors at the line it started on.
+Value parseSource(string_view text, const string& path, size_t line) {
+  try {
+    return Lexer(text).parseElement();
+  } catch (const ParserException& exn) {
+    throw ParserException(
+        path + ":" + to_string(line) + ": " + exn.getMessage(),
+        exn.getContext(), exn.getLocation());
+  }
+}
+
+// Pushes and executes each element of the included file at the path.
+void runSource(Stack& s, const Scope& e, ifstream& fin, const string& path,
+               const string& file) {
+  vector<Value> elements;
+  if (readCache(file, elements)) {  // already parsed
+    fin.close();
+    for (const Value& elm : elements) {
+      try {
+        s.push(elm);
+      } catch (const StackOverflowError&) {
+        throw StackOverflowError(s.getLimit());
+      }
+      execute(s, e);
+    }
+    return;
+  }
+
+  SourceReader source(fin, path);
+  fin.close();
+
+  string_view text;
+  size_t line;
+  while (source.next(text, line)) {
+    Value elm = parseSource(text, path, line);
+    try {
+      s.push(elm);
+    } catch (const StackOverflowError&) {
+      throw StackOverflowError(s.getLimit());
+    }
+    elements.push_back(elm);
+    execute(s, e);
+  }
+  writeCache(file, elements);
+}
+}  // namespace
+
+const PrimitiveEntry PRIMITIVES[] = {
+#include "language/primitives/boolean.inc"
+#include "language/primitives/command.inc"
+#include "language/primitives/number.inc"
+#include "language/primitives/special.inc"
+#include "language/primitives/string.inc"
+#include "language/primitives/substack.inc"
+#include "language/primitives/type.inc"
+};
+
+const size_t NUM_PRIMITIVES = sizeof(PRIMITIVES) / sizeof(PRIMITIVES[0]);
+}  // namespace stacklang
@@ -0,0 +1,46 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Table of the primitive commands, generated from their definitions in
+// language/primitives.
+
+#ifndef STACKLANG_LANGUAGE_PRIMITIVES_H_
+#define STACKLANG_LANGUAGE_PRIMITIVES_H_
+
+#include <cstddef>
+
+#include "language/environment.h"
+#include "language/stack/stack.h"
+
+namespace stacklang {
+class Scope;
+
+// Implementation of a primitive command, run in the scope it was called from.
+// Primitives are identified by their opcode - their index in PRIMITIVES.
+typedef void (*Primitive)(Stack&, const Scope&);
+
+struct PrimitiveEntry {
+  const char* name;
+  Primitive fun;
+};
+
+extern const PrimitiveEntry PRIMITIVES[];
+extern const size_t NUM_PRIMITIVES;
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_PRIMITIVES_H_
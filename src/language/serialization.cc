@@ -0,0 +1,201 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the binary encoding of stack elements.
+
+#include "language/serialization.h"
+
+#include <string>
+#include <vector>
+
+#include "language/exceptions/languageExceptions.h"
+
+namespace stacklang {
+namespace {
+using exceptions::RuntimeError;
+using stackelements::CommandElement;
+using stackelements::IdentifierElement;
+using stackelements::StringElement;
+using stackelements::SubstackElement;
+using stackelements::TypeElement;
+using stackelements::TypePtr;
+using std::string;
+using std::string_view;
+using std::uint64_t;
+using std::vector;
+
+const unsigned char MAX_TYPE =
+    static_cast<unsigned char>(StackElement::DataType::Any);
+}  // namespace
+
+void Encoder::writeSize(uint64_t size) { write(size); }
+
+void Encoder::writeString(const string& s) {
+  writeSize(s.length());
+  buffer += s;
+}
+
+void Encoder::writeValue(const Value& elm) {
+  StackElement::DataType type = elm.getType();
+  write(static_cast<unsigned char>(type));
+  switch (type) {
+    case StackElement::DataType::Number: {
+      write(elm.getNumber());
+      write(elm.getPrecision());
+      break;
+    }
+    case StackElement::DataType::Boolean: {
+      write(static_cast<unsigned char>(elm.getBoolean()));
+      break;
+    }
+    case StackElement::DataType::String: {
+      writeString(static_cast<const StringElement*>(elm.get())->getData());
+      break;
+    }
+    case StackElement::DataType::Identifier: {
+      const IdentifierElement* id =
+          static_cast<const IdentifierElement*>(elm.get());
+      write(static_cast<unsigned char>(id->isQuoted()));
+      writeString(id->getName());
+      break;
+    }
+    case StackElement::DataType::Substack: {
+      writeStack(static_cast<const SubstackElement*>(elm.get())->getData());
+      break;
+    }
+    case StackElement::DataType::Type: {
+      writeType(elm.getBase(), elm.getSpecialization());
+      break;
+    }
+    case StackElement::DataType::Command: {
+      writeCommand(*static_cast<const CommandElement*>(elm.get()));
+      break;
+    }
+    default: {
+      throw RuntimeError("Cannot save an empty value.");
+    }
+  }
+}
+
+void Encoder::writeStack(const Stack& s) {
+  writeSize(s.size());
+  for (const Value& elm : s) writeValue(elm);  // from the top down
+}
+
+const string& Encoder::getBuffer() const noexcept { return buffer; }
+
+void Encoder::writeCommand(const CommandElement&) {
+  throw RuntimeError("Cannot save a command.");
+}
+
+void Encoder::writeType(StackElement::DataType base, const TypeElement* spec) {
+  write(static_cast<unsigned char>(base));
+  write(static_cast<unsigned char>(spec != nullptr));
+  if (spec != nullptr) writeType(spec->getBase(), spec->getSpecialization());
+}
+
+Decoder::Decoder(string_view data) noexcept : buffer{data}, pos{0} {}
+
+bool Decoder::readString(string& s) {
+  uint64_t length;
+  if (!read(length) || buffer.length() - pos < length) return false;
+  s.assign(buffer.data() + pos, length);
+  pos += length;
+  return true;
+}
+
+bool Decoder::readValue(Value& elm) {
+  unsigned char type;
+  if (!read(type)) return false;
+  switch (static_cast<StackElement::DataType>(type)) {
+    case StackElement::DataType::Number: {
+      long double number;
+      int precision;
+      if (!read(number) || !read(precision)) return false;
+      elm = Value(number, precision);
+      return true;
+    }
+    case StackElement::DataType::Boolean: {
+      unsigned char boolean;
+      if (!read(boolean)) return false;
+      elm = Value(boolean != 0);
+      return true;
+    }
+    case StackElement::DataType::String: {
+      string data;
+      if (!readString(data)) return false;
+      elm = Value(new StringElement(data));
+      return true;
+    }
+    case StackElement::DataType::Identifier: {
+      unsigned char quoted;
+      string name;
+      if (!read(quoted) || !readString(name)) return false;
+      elm = Value(new IdentifierElement(name, quoted != 0));
+      return true;
+    }
+    case StackElement::DataType::Substack: {
+      Stack data;
+      if (!readStack(data)) return false;
+      elm = Value(new SubstackElement(data));
+      return true;
+    }
+    case StackElement::DataType::Type: {
+      TypePtr data;
+      if (!readType(data)) return false;
+      elm = Value(data);
+      return true;
+    }
+    case StackElement::DataType::Command: {
+      return readCommand(elm);
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool Decoder::readStack(Stack& s) {
+  uint64_t size;
+  if (!read(size) || size > buffer.length() - pos) return false;
+  vector<Value> elms(size);
+  for (Value& elm : elms) {
+    if (!readValue(elm)) return false;
+  }
+
+  s.clear();
+  s.reserve(elms.size());
+  for (auto iter = elms.rbegin(); iter != elms.rend(); iter++) s.push(*iter);
+  return true;
+}
+
+bool Decoder::isDone() const noexcept { return pos == buffer.length(); }
+
+bool Decoder::readCommand(Value&) { return false; }
+
+bool Decoder::readType(TypePtr& type) {
+  unsigned char base;
+  unsigned char hasSpec;
+  if (!read(base) || !read(hasSpec) || base > MAX_TYPE) return false;
+
+  TypePtr spec;
+  if (hasSpec != 0 && !readType(spec)) return false;
+  type = new TypeElement(static_cast<StackElement::DataType>(base), spec);
+  return true;
+}
+}  // namespace stacklang
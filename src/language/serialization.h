@@ -0,0 +1,106 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Binary encoding of stack elements, used by caches and images.
+
+#ifndef STACKLANG_LANGUAGE_SERIALIZATION_H_
+#define STACKLANG_LANGUAGE_SERIALIZATION_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "language/stack/stack.h"
+#include "language/stack/stackElements.h"
+
+namespace stacklang {
+// Encodes values into a buffer. The encoding is only meant to be read back
+// by the same build of the interpreter.
+class Encoder {
+ public:
+  Encoder() noexcept = default;
+  Encoder(const Encoder&) = delete;
+
+  virtual ~Encoder() noexcept = default;
+
+  Encoder& operator=(const Encoder&) = delete;
+
+  // Writes the bytes of plain data.
+  template <typename T>
+  void write(const T& data) {
+    buffer.append(reinterpret_cast<const char*>(&data), sizeof(T));
+  }
+  // Sizes are always written as 64 bits.
+  void writeSize(std::uint64_t);
+  void writeString(const std::string&);
+  void writeValue(const Value&);
+  void writeStack(const Stack&);
+
+  const std::string& getBuffer() const noexcept;
+
+ protected:
+  // Writes a command. Commands are not encoded by default - this throws
+  // RuntimeError.
+  virtual void writeCommand(const stackelements::CommandElement&);
+
+ private:
+  void writeType(StackElement::DataType base,
+                 const stackelements::TypeElement* spec);
+
+  std::string buffer;
+};
+
+// Decodes what an Encoder wrote. Every read is checked, since the data may be
+// truncated or corrupt, and failures are reported by giving false.
+class Decoder {
+ public:
+  explicit Decoder(std::string_view) noexcept;
+  Decoder(const Decoder&) = delete;
+
+  virtual ~Decoder() noexcept = default;
+
+  Decoder& operator=(const Decoder&) = delete;
+
+  template <typename T>
+  bool read(T& data) noexcept {
+    if (buffer.length() - pos < sizeof(T)) return false;
+    std::memcpy(&data, buffer.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+  bool readString(std::string&);
+  bool readValue(Value&);
+  bool readStack(Stack&);
+
+  // Checks that all of the data has been read.
+  bool isDone() const noexcept;
+
+ protected:
+  // Reads what writeCommand wrote. Gives false by default.
+  virtual bool readCommand(Value&);
+
+ private:
+  bool readType(stackelements::TypePtr&);
+
+  std::string_view buffer;
+  size_t pos;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_SERIALIZATION_H_
@@ -0,0 +1,89 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Storage for the parameters of running commands.
+
+#ifndef STACKLANG_LANGUAGE_SLOTARENA_H_
+#define STACKLANG_LANGUAGE_SLOTARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "language/stack/stack.h"
+
+namespace stacklang {
+// Commands return in the reverse of the order they were called, so slots are
+// bumped off the end of a chunk and given back by returning to an earlier
+// mark. An arena is used by one thread at a time.
+class SlotArena {
+ public:
+  struct Mark {
+    size_t chunk;
+    size_t used;
+  };
+
+  Mark mark() const noexcept { return Mark{current, used}; }
+
+  Value* allocate(size_t n) {
+    if (chunks.empty()) {
+      chunks.emplace_back(std::max(CHUNK_SIZE, n));
+    } else if (used + n > chunks[current].size()) {
+      current++;
+      used = 0;
+      if (current == chunks.size()) {
+        chunks.emplace_back(std::max(CHUNK_SIZE, n));
+      } else if (chunks[current].size() < n) {
+        chunks[current] = std::vector<Value>(n);
+      }
+    }
+
+    Value* slots = chunks[current].data() + used;
+    used += n;
+    return slots;
+  }
+
+  // Empties all slots allocated since the mark.
+  void release(Mark m) noexcept {
+    while (current > m.chunk) {
+      std::fill_n(chunks[current].begin(), used, Value());
+      current--;
+      used = chunks[current].size();
+    }
+    std::fill(chunks[current].begin() + static_cast<ptrdiff_t>(m.used),
+              chunks[current].begin() + static_cast<ptrdiff_t>(used), Value());
+    used = m.used;
+  }
+
+  // Gives the number of slots held, in use or not.
+  size_t capacity() const noexcept {
+    size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.size();
+    return total;
+  }
+
+ private:
+  static constexpr size_t CHUNK_SIZE = 1024;
+
+  std::vector<std::vector<Value>> chunks;  // never resized, so slots stay put
+  size_t current = 0;
+  size_t used = 0;  // slots of the current chunk
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_SLOTARENA_H_
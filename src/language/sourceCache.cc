@@ -0,0 +1,156 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the parsed source cache.
+
+#include "language/sourceCache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "language/serialization.h"
+#include "util/stringUtils.h"
+
+namespace stacklang {
+namespace {
+using std::error_code;
+using std::ifstream;
+using std::memcmp;
+using std::ofstream;
+using std::random_device;
+using std::streamsize;
+using std::string;
+using std::strlen;
+using std::to_string;
+using std::uint64_t;
+using std::uintmax_t;
+using std::vector;
+using util::ends_with;
+
+namespace fs = std::filesystem;
+
+// changed whenever the format changes, so old caches are not misread.
+const char MAGIC[] = "STC1";
+const char SOURCE_EXTENSION[] = ".sta";
+const char CACHE_EXTENSION[] = ".stc";
+
+// Identifies a version of a source file.
+struct Stamp {
+  uint64_t size;
+  uint64_t mtime;
+};
+
+bool getStamp(const string& source, Stamp& stamp) noexcept {
+  error_code err;
+  uintmax_t size = fs::file_size(source, err);
+  if (err) return false;
+  fs::file_time_type mtime = fs::last_write_time(source, err);
+  if (err) return false;
+
+  stamp.size = size;
+  stamp.mtime = static_cast<uint64_t>(mtime.time_since_epoch().count());
+  return true;
+}
+
+}  // namespace
+
+string cachePath(const string& source) {
+  if (!ends_with(source, SOURCE_EXTENSION)) return "";
+  return source.substr(0, source.length() - strlen(SOURCE_EXTENSION)) +
+         CACHE_EXTENSION;
+}
+
+bool readCache(const string& source, vector<Value>& elements) {
+  string path = cachePath(source);
+  Stamp stamp;
+  if (path.empty() || !getStamp(source, stamp)) return false;
+
+  ifstream fin(path, ifstream::binary);
+  if (!fin.is_open()) return false;
+  string data;
+  error_code err;
+  uintmax_t size = fs::file_size(path, err);
+  if (err) return false;
+  data.resize(size);
+  if (!fin.read(&data[0], static_cast<streamsize>(size))) return false;
+
+  Decoder reader(data);
+  char magic[sizeof(MAGIC)];
+  unsigned char numberSize;
+  Stamp cached;
+  uint64_t count;
+  if (!reader.read(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      !reader.read(numberSize) || numberSize != sizeof(long double) ||
+      !reader.read(cached.size) || !reader.read(cached.mtime) ||
+      cached.size != stamp.size || cached.mtime != stamp.mtime ||
+      !reader.read(count) || count > size) {
+    return false;
+  }
+
+  vector<Value> read(count);
+  for (Value& elm : read) {
+    if (!reader.readValue(elm)) return false;
+  }
+  if (!reader.isDone()) return false;
+
+  elements.swap(read);
+  return true;
+}
+
+void writeCache(const string& source, const vector<Value>& elements) noexcept {
+  try {
+    string path = cachePath(source);
+    Stamp stamp;
+    if (path.empty() || !getStamp(source, stamp)) return;
+
+    Encoder writer;
+    writer.write(MAGIC);
+    writer.write(static_cast<unsigned char>(sizeof(long double)));
+    writer.write(stamp.size);
+    writer.write(stamp.mtime);
+    writer.writeSize(elements.size());
+    for (const Value& elm : elements) writer.writeValue(elm);
+
+    // written beside the cache, then moved over it, so other interpreters
+    // never see a partial cache.
+    string temp = path + "." + to_string(random_device()());
+    {
+      ofstream fout(temp, ofstream::binary | ofstream::trunc);
+      if (!fout.is_open()) return;
+      fout.write(writer.getBuffer().data(),
+                 static_cast<streamsize>(writer.getBuffer().length()));
+      if (!fout) {
+        fout.close();
+        fs::remove(temp);
+        return;
+      }
+    }
+
+    error_code err;
+    fs::rename(temp, path, err);
+    if (err) fs::remove(temp, err);
+  } catch (...) {  // the source is used without a cache
+  }
+}
+}  // namespace stacklang
@@ -0,0 +1,48 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Cache of the parsed elements of included files.
+
+#ifndef STACKLANG_LANGUAGE_SOURCECACHE_H_
+#define STACKLANG_LANGUAGE_SOURCECACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "language/stack/stack.h"
+
+namespace stacklang {
+// The elements of a .sta file are cached in a .stc file next to it, so
+// including it again needs no parsing. The cache records the size and
+// modification time of the file, and is only used while they match.
+
+// Gives the path of the cache for a source file, or an empty string if the
+// file does not have a .sta extension.
+std::string cachePath(const std::string& source);
+
+// Reads the cached elements of a source file. Gives false if there is no
+// usable cache - it is missing, out of date, or unreadable.
+bool readCache(const std::string& source, std::vector<Value>& elements);
+
+// Replaces the cache of a source file. Failures are ignored, since the cache
+// can always be rebuilt.
+void writeCache(const std::string& source,
+                const std::vector<Value>& elements) noexcept;
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_SOURCECACHE_H_
@@ -0,0 +1,179 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the source file splitter.
+
+#include "language/sourceReader.h"
+
+#include <cstring>
+#include <string>
+
+#include "language/exceptions/interpreterExceptions.h"
+#include "util/stringUtils.h"
+
+namespace stacklang {
+namespace {
+using exceptions::ParserException;
+using std::istream;
+using std::strchr;
+using std::string;
+using std::string_view;
+using std::to_string;
+using util::ends_with;
+using util::WHITESPACE;
+
+const size_t BLOCK_SIZE = 1 << 16;
+
+bool isSpace(char c) noexcept { return strchr(WHITESPACE, c) != nullptr; }
+}  // namespace
+
+SourceReader::SourceReader(istream& in, const string& n)
+    : name{n},
+      pos{0},
+      lineNumber{1},
+      runBegin{0},
+      sliceBegin{0},
+      sliceEnd{0},
+      hasSlice{false},
+      buffered{false} {
+  size_t size = 0;
+  do {
+    data.resize(size + BLOCK_SIZE);
+    in.read(&data[size], BLOCK_SIZE);
+    size += static_cast<size_t>(in.gcount());
+  } while (in);
+  data.resize(size);
+}
+
+bool SourceReader::next(string_view& text, size_t& line) {
+  size_t substackLevel = 0;
+  bool inString = false;
+  bool inComment = false;
+  bool setPrevChar = true;
+  char prevChar = '\0';
+
+  runBegin = pos;
+  hasSlice = false;
+  buffered = false;
+  buffer.clear();
+
+  for (; pos < data.size(); pos++) {
+    char c = data[pos];
+    if (c == ';' && !inString) {
+      if (!inComment) endRun(pos);
+      inComment = true;
+      continue;
+    } else if (c == '\n') {
+      if (!inComment) endRun(pos);
+      line = lineNumber++;
+      runBegin = pos + 1;
+
+      if (substackLevel == 0) {
+        text = element();
+        if (!text.empty()) {
+          pos++;
+          return true;
+        }
+        hasSlice = false;
+        buffered = false;
+        buffer.clear();
+      } else {  // each line of a substack is an item of it
+        if (!buffered) {
+          buffer.assign(data, sliceBegin, sliceEnd - sliceBegin);
+          buffered = true;
+        }
+        if (buffer.back() != ',' && !inString && !ends_with(buffer, "<<")) {
+          buffer += ',';
+        }
+      }
+      inString = false;
+      inComment = false;
+      prevChar = '\0';
+      continue;
+    } else if (inComment) {
+      continue;
+    } else if (c == '"' && !inString) {
+      inString = true;
+    } else if (c == '"' && inString && prevChar != '\\') {
+      inString = false;
+    } else if (c == '\\' && inString && prevChar == '\\') {
+      prevChar = '\0';
+      setPrevChar = false;
+    } else if (c == '<' && prevChar == '<' && !inString) {
+      prevChar = '\0';
+      setPrevChar = false;
+      substackLevel++;
+    } else if (c == '>' && prevChar == '>' && !inString) {
+      prevChar = '\0';
+      setPrevChar = false;
+      if (substackLevel == 0) {
+        throw ParserException(name + ":" + to_string(lineNumber) +
+                                  ": Found unmatched closing substack "
+                                  "delimiter.",
+                              "", 0);
+      }
+      substackLevel--;
+    }
+
+    if (setPrevChar) prevChar = c;
+    setPrevChar = true;
+  }
+
+  if (!inComment) endRun(pos);
+  runBegin = pos;
+  line = lineNumber;
+  if (substackLevel > 0) {
+    throw ParserException(name + ":" + to_string(lineNumber) + ": Missing " +
+                              to_string(substackLevel) +
+                              " closing substack delimiter" +
+                              (substackLevel > 1 ? "s" : "") + ".",
+                          "", 0);
+  }
+  text = element();
+  return !text.empty();
+}
+
+void SourceReader::endRun(size_t end) {
+  if (!hasSlice) {
+    sliceBegin = runBegin;
+    sliceEnd = end;
+    hasSlice = true;
+    return;
+  }
+
+  if (!buffered) {
+    buffer.assign(data, sliceBegin, sliceEnd - sliceBegin);
+    buffered = true;
+  }
+  buffer.append(data, runBegin, end - runBegin);
+}
+
+string_view SourceReader::element() const noexcept {
+  string_view text;
+  if (buffered) {
+    text = buffer;
+  } else if (hasSlice) {
+    text = string_view(data).substr(sliceBegin, sliceEnd - sliceBegin);
+  }
+  size_t begin = 0;
+  size_t end = text.length();
+  while (begin < end && isSpace(text[begin])) begin++;
+  while (end > begin && isSpace(text[end - 1])) end--;
+  return text.substr(begin, end - begin);
+}
+}  // namespace stacklang
@@ -0,0 +1,67 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Splitter for the text of included files.
+
+#ifndef STACKLANG_LANGUAGE_SOURCEREADER_H_
+#define STACKLANG_LANGUAGE_SOURCEREADER_H_
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+
+namespace stacklang {
+// Reads a whole source file in large blocks, then splits it into the text of
+// its top level elements in one pass. Elements end at the end of a line,
+// unless a substack is open, in which case each line of the substack is
+// another item of it. Comments, strings and substack delimiters are tracked
+// as the text is scanned.
+class SourceReader {
+ public:
+  // Reads all of the stream. Errors are reported as being in the named file.
+  SourceReader(std::istream&, const std::string& name);
+
+  // Finds the next element, giving its text and the line it ends on. The text
+  // is only valid until the next call. Gives false at the end of the file.
+  // Throws ParserException if substack delimiters do not match.
+  bool next(std::string_view& element, size_t& line);
+
+ private:
+  // Ends the run of text being added to the element at end.
+  void endRun(size_t end);
+  // Gives the text of the element with whitespace trimmed.
+  std::string_view element() const noexcept;
+
+  std::string name;
+  std::string data;
+  size_t pos;         // of the next character to scan
+  size_t lineNumber;  // of the next character
+
+  // Elements that are one run of the file (usually so) are not copied.
+  // Others are built in buffer.
+  size_t runBegin;
+  size_t sliceBegin;
+  size_t sliceEnd;
+  bool hasSlice;
+  bool buffered;
+  std::string buffer;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_SOURCEREADER_H_
@@ -0,0 +1,372 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the single pass element parser.
+
+#include "language/stack/lexer.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "language/exceptions/interpreterExceptions.h"
+#include "util/stringUtils.h"
+
+namespace stacklang {
+namespace {
+using exceptions::ParserException;
+using stackelements::BooleanElement;
+using stackelements::IdentifierElement;
+using stackelements::NumberElement;
+using stackelements::StringElement;
+using stackelements::SubstackElement;
+using stackelements::TypeElement;
+using std::size;
+using std::strchr;
+using std::strlen;
+using std::string_view;
+using std::strtold;
+using std::to_string;
+using std::vector;
+using util::WHITESPACE;
+
+const size_t NONE = std::string::npos;
+
+bool isDigit(char c) noexcept {
+  return isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+bool isAlpha(char c) noexcept {
+  return isalpha(static_cast<unsigned char>(c)) != 0;
+}
+
+bool isSpace(char c) noexcept { return strchr(WHITESPACE, c) != nullptr; }
+
+bool isIdentifierChar(char c) noexcept {
+  return isalnum(static_cast<unsigned char>(c)) != 0 || c == '-' ||
+         c == '?' || c == '*';
+}
+}  // namespace
+
+Lexer::Lexer(string_view t) noexcept : text{t} {}
+
+StackElement* Lexer::parseElement() { return element(0, text.length()); }
+
+IdentifierElement* Lexer::parseIdentifier() {
+  return identifier(0, text.length());
+}
+
+NumberElement* Lexer::parseNumber() { return number(0, text.length(), true); }
+
+StringElement* Lexer::parseString() { return string(0, text.length()); }
+
+SubstackElement* Lexer::parseSubstack() {
+  if (!startsWith(0, text.length(), SubstackElement::SUBSTACK_BEGIN) ||
+      text.length() < 4 ||
+      text.compare(text.length() - 2, 2, SubstackElement::SUBSTACK_END) != 0) {
+    error("Input is not a substack.", 0);
+  }
+  return substack(0, text.length());
+}
+
+TypeElement* Lexer::parseType() { return type(0, text.length()); }
+
+StackElement* Lexer::element(size_t begin, size_t end) {
+  if (begin == end) error("Given input is empty.", begin);
+
+  char first = text[begin];
+  if (isDigit(first)) {
+    return number(begin, end, true);
+  } else if (first == '-' || first == '+') {  // a number, if it has digits
+    NumberElement* num = number(begin, end, false);
+    if (num != nullptr) return num;
+  } else if (first == StringElement::QUOTE_CHAR) {
+    return string(begin, end);
+  } else if (startsWith(begin, end, SubstackElement::SUBSTACK_BEGIN) &&
+             end - begin >= 2 && text[end - 1] == '>' &&
+             text[end - 2] == '>') {
+    return substack(begin, end);
+  }
+
+  // anything else is a word - a boolean, a type, or an identifier.
+  bool quoted = first == IdentifierElement::QUOTE_CHAR;
+  size_t bad = NONE;
+  bool hasParens = false;
+  for (size_t i = quoted ? begin + 1 : begin; i < end; i++) {
+    if (text[i] == '(' || text[i] == ')') hasParens = true;
+    if (bad == NONE && !isIdentifierChar(text[i])) bad = i;
+  }
+
+  if (equals(begin, end, BooleanElement::TSTR) ||
+      equals(begin, end, BooleanElement::FSTR)) {
+    return new BooleanElement(equals(begin, end, BooleanElement::TSTR));
+  } else if (hasParens) {
+    return type(begin, end);
+  } else if (isupper(static_cast<unsigned char>(first))) {
+    for (string_view name : TypeElement::TYPES) {
+      if (equals(begin, end, name)) return type(begin, end);
+    }
+  }
+
+  if (!isAlpha(first) &&
+      !(quoted && end - begin >= 2 && isAlpha(text[begin + 1]))) {
+    error("Input doesn't look like any type - does it begin with a symbol?",
+          begin);
+  } else if (bad == NONE) {
+    size_t start = quoted ? begin + 1 : begin;
+    return new IdentifierElement(Symbol(text.substr(start, end - start)),
+                                 quoted);
+  } else if (text[bad] == ' ') {
+    error("Input looks like a command, but has a space.", bad);
+  } else {
+    error("Input looks like a command, but has a symbol that is not in `-?*`.",
+          bad);
+  }
+}
+
+IdentifierElement* Lexer::identifier(size_t begin, size_t end) {
+  bool quoted = begin < end && text[begin] == IdentifierElement::QUOTE_CHAR;
+  size_t start = quoted ? begin + 1 : begin;
+
+  for (size_t i = start; i < end; i++) {
+    if (!isIdentifierChar(text[i])) {
+      if (text[i] == ' ') {
+        error("Input looks like a command, but has a space.", i);
+      } else {
+        error(
+            "Input looks like a command, but has a symbol that is not in "
+            "`-?*`.",
+            i);
+      }
+    }
+  }
+
+  if (start == end || !isAlpha(text[start])) {
+    error("Input does not begin with an alphabetic character.", start);
+  }
+  return new IdentifierElement(Symbol(text.substr(start, end - start)),
+                               quoted);
+}
+
+NumberElement* Lexer::number(size_t begin, size_t end, bool required) {
+  size_t bad = NONE;
+  size_t dot = NONE;
+  size_t secondDot = NONE;
+  size_t lastSign = NONE;
+  bool hasDigits = false;
+  int precision = 0;
+
+  for (size_t i = begin; i < end; i++) {
+    char c = text[i];
+    if (isDigit(c)) {
+      hasDigits = true;
+      if (dot != NONE) precision++;
+    } else if (c == '.') {
+      if (dot == NONE) {
+        dot = i;
+      } else if (secondDot == NONE) {
+        secondDot = i;
+      }
+    } else if (c == '-' || c == '+') {
+      lastSign = i;
+    } else if (c != '\'' && bad == NONE) {
+      bad = i;
+    }
+  }
+
+  if (!hasDigits && !required) {
+    return nullptr;
+  } else if (bad != NONE) {
+    error("Looks like a number, but has an unexpected character.", bad);
+  } else if (secondDot != NONE) {
+    error("Looks like a number, but has more than one deminal point.",
+          secondDot);
+  } else if (lastSign != NONE && lastSign != begin) {
+    error("Looks like a number, but has a sign in the middle.", lastSign);
+  } else if (!hasDigits) {
+    error("Looks like a number, but has no digits.", begin);
+  }
+
+  // the text may not be terminated, so the number is copied to convert it.
+  std::string digits;
+  digits.reserve(end - begin);
+  for (size_t i = begin; i < end; i++) {
+    if (text[i] != '\'') digits += text[i];
+  }
+  return new NumberElement(strtold(digits.c_str(), nullptr), precision);
+}
+
+StringElement* Lexer::string(size_t begin, size_t end) {
+  if (end == begin || text[end - 1] != StringElement::QUOTE_CHAR) {
+    error("Looks like a string, but is missing a closing quote.", end);
+  }
+
+  std::string data;
+  size_t last = end - 1 > begin ? end - 1 : begin + 1;
+  data.reserve(last - begin);
+  for (size_t i = begin + 1; i < last; i++) {
+    char c = text[i];
+    if (c == '\\' && i + 1 < last) {
+      char escaped = text[i + 1];
+      if (escaped == 'n' || escaped == 't' || escaped == '"' ||
+          escaped == '\\') {
+        data += escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+        i++;
+        continue;
+      }
+    }
+    if (c == '\\' || c == StringElement::QUOTE_CHAR) {
+      error("Looks like a string, but has an invalid escape sequence", i);
+    }
+    data += c;
+  }
+
+  return new StringElement(data);
+}
+
+SubstackElement* Lexer::substack(size_t begin, size_t end) {
+  vector<vector<Value>> open(1);  // items so far, innermost substack last
+  bool needItem = true;           // just after an opening delimiter or a comma
+  size_t pos = begin + 2;
+
+  while (true) {
+    pos = skipSpace(pos, end);
+    if (pos == end) {
+      size_t missing = open.size();
+      error("Missing " + to_string(missing) + " closing substack delimiter" +
+                (missing == 1 ? "" : "s") + ".",
+            end - 1);
+    } else if (startsWith(pos, end, SubstackElement::SUBSTACK_END)) {
+      // items are listed from the top down.
+      const vector<Value>& items = open.back();
+      Stack data;
+      data.reserve(items.size());
+      for (auto iter = items.rbegin(); iter != items.rend(); iter++) {
+        data.push(*iter);
+      }
+      open.pop_back();
+      pos += 2;
+
+      if (open.empty()) {
+        if (pos != end) {
+          error("Missing at least one matching opening substack delimiter.",
+                pos - 2);
+        }
+        return new SubstackElement(data);
+      }
+      open.back().emplace_back(new SubstackElement(data));
+      needItem = false;
+    } else if (!needItem) {
+      if (text[pos] != ',') {
+        error("Expected a comma or the end of the substack.", pos);
+      }
+      pos++;
+      needItem = true;
+    } else if (text[pos] == ',') {
+      error("Given input is empty.", pos);
+    } else if (startsWith(pos, end, SubstackElement::SUBSTACK_BEGIN)) {
+      open.emplace_back();
+      pos += 2;
+    } else {
+      size_t itemBegin = pos;
+      pos = itemEnd(pos, end);
+      size_t last = pos;
+      while (isSpace(text[last - 1])) last--;
+      open.back().emplace_back(element(itemBegin, last));
+      needItem = false;
+    }
+  }
+}
+
+TypeElement* Lexer::type(size_t begin, size_t end) {
+  size_t open = NONE;
+  for (size_t i = begin; i < end && open == NONE; i++) {
+    if (text[i] == '(') open = i;
+  }
+
+  if (open == NONE) {
+    for (size_t i = 0; i < size(TypeElement::TYPES); i++) {
+      if (equals(begin, end, TypeElement::TYPES[i])) {
+        return new TypeElement(static_cast<StackElement::DataType>(i));
+      }
+    }
+    error("Input is not a type.", begin);
+  }
+
+  StackElement::DataType base;
+  if (startsWith(begin, end, "Substack")) {
+    base = StackElement::DataType::Substack;
+  } else if (startsWith(begin, end, "Command")) {
+    base = StackElement::DataType::Command;
+  } else if (startsWith(begin, end, "Identifier")) {
+    base = StackElement::DataType::Identifier;
+  } else {
+    error(
+        "Cannot have a specialization except on a Substack, Command, or "
+        "Identifier.",
+        open);
+  }
+
+  // the specialization is between the parentheses.
+  return new TypeElement(base, type(open + 1, end - 1 > open ? end - 1 : end));
+}
+
+size_t Lexer::itemEnd(size_t begin, size_t end) const noexcept {
+  bool inString = false;
+  for (size_t i = begin; i < end; i++) {
+    if (inString) {
+      if (text[i] == '\\') {
+        i++;  // skip the escaped character
+      } else if (text[i] == StringElement::QUOTE_CHAR) {
+        inString = false;
+      }
+    } else if (text[i] == StringElement::QUOTE_CHAR) {
+      inString = true;
+    } else if (text[i] == ',' ||
+               startsWith(i, end, SubstackElement::SUBSTACK_BEGIN) ||
+               startsWith(i, end, SubstackElement::SUBSTACK_END)) {
+      return i;
+    }
+  }
+  return end;
+}
+
+size_t Lexer::skipSpace(size_t begin, size_t end) const noexcept {
+  while (begin < end && isSpace(text[begin])) begin++;
+  return begin;
+}
+
+void Lexer::error(const std::string& message, size_t location) const {
+  throw ParserException(message, std::string(text), location);
+}
+
+bool Lexer::startsWith(size_t begin, size_t end, const char* prefix) const
+    noexcept {
+  size_t length = strlen(prefix);
+  return end - begin >= length && text.compare(begin, length, prefix) == 0;
+}
+
+bool Lexer::equals(size_t begin, size_t end,
+                   string_view word) const noexcept {
+  return text.compare(begin, end - begin, word) == 0;
+}
+}  // namespace stacklang
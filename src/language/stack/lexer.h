@@ -0,0 +1,78 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Single pass parser for the text of stack elements.
+
+#ifndef STACKLANG_LANGUAGE_STACK_LEXER_H_
+#define STACKLANG_LANGUAGE_STACK_LEXER_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "language/stack/stack.h"
+#include "language/stack/stackElements.h"
+
+namespace stacklang {
+// Parses the text of one element, looking at each character once, and builds
+// the element directly. Errors are reported with the whole text as context,
+// at the position of the offending character.
+class Lexer {
+ public:
+  explicit Lexer(std::string_view text) noexcept;
+
+  // Works out what kind of element the text is, and parses it as that.
+  StackElement* parseElement();
+
+  stackelements::IdentifierElement* parseIdentifier();
+  stackelements::NumberElement* parseNumber();
+  stackelements::StringElement* parseString();
+  stackelements::SubstackElement* parseSubstack();
+  stackelements::TypeElement* parseType();
+
+ private:
+  // Each of these parses the text between begin and end.
+  StackElement* element(size_t begin, size_t end);
+  stackelements::IdentifierElement* identifier(size_t begin, size_t end);
+  // Gives nullptr instead of an error if there are no digits, and the number
+  // is not required.
+  stackelements::NumberElement* number(size_t begin, size_t end,
+                                       bool required);
+  stackelements::StringElement* string(size_t begin, size_t end);
+  // Parses a substack and all substacks in it in one pass, keeping the items
+  // of the open substacks instead of recursing, so deep nesting is fine.
+  stackelements::SubstackElement* substack(size_t begin, size_t end);
+  stackelements::TypeElement* type(size_t begin, size_t end);
+
+  // Gives the end of the substack item starting at begin - the next comma or
+  // substack delimiter that is not in a string.
+  size_t itemEnd(size_t begin, size_t end) const noexcept;
+  size_t skipSpace(size_t begin, size_t end) const noexcept;
+
+  // Throws a ParserException at the location, with all of the text as context.
+  [[noreturn]] void error(const std::string& message, size_t location) const;
+
+  bool startsWith(size_t begin, size_t end, const char* prefix) const
+      noexcept;
+  bool equals(size_t begin, size_t end, std::string_view word) const noexcept;
+
+  std::string_view text;
+};
+}  // namespace stacklang
+
+#endif  // STACKLANG_LANGUAGE_STACK_LEXER_H_
@@ -22,225 +22,450 @@
 #include "language/stack/stack.h"
 
 #include <algorithm>
-#include <cstring>
+#include <atomic>
+#include <cstddef>
 #include <limits>
-#include <queue>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "language/exceptions/interpreterExceptions.h"
 #include "language/exceptions/languageExceptions.h"
+#include "language/stack/lexer.h"
 #include "language/stack/stackElements.h"
-#include "util/stringUtils.h"
 
 namespace stacklang {
 namespace {
 using stacklang::StackElement;
-using stacklang::exceptions::ParserException;
 using stacklang::exceptions::StackOverflowError;
 using stacklang::exceptions::StackUnderflowError;
 using stacklang::stackelements::BooleanElement;
-using stacklang::stackelements::IdentifierElement;
 using stacklang::stackelements::NumberElement;
-using stacklang::stackelements::StringElement;
-using stacklang::stackelements::SubstackElement;
 using stacklang::stackelements::TypeElement;
-using std::any_of;
-using std::find;
+using std::atomic;
 using std::initializer_list;
-using std::make_unique;
+using std::make_shared;
+using std::move;
 using std::numeric_limits;
-using std::queue;
+using std::shared_ptr;
 using std::string;
-using util::ends_with;
-using util::starts_with;
+using std::vector;
+
+atomic<size_t> allocationCount = 0;
+atomic<size_t> liveCount = 0;
 }  // namespace
 
-// Acts as a dispatcher for specific types, and handles parsing of trivially
-// parsed types (currently just Booleans).
 StackElement* StackElement::parse(const string& s) {
-  if (s.empty()) {
-    throw ParserException("Given input is empty.", s, 0);
-  } else if (isdigit(s[0]) ||
-             (find(NumberElement::NUMBER_SIGNS,
-                   NumberElement::NUMBER_SIGNS +
-                       strlen(NumberElement::NUMBER_SIGNS),
-                   s[0]) != NumberElement::NUMBER_SIGNS +
-                                strlen(NumberElement::NUMBER_SIGNS) &&
-              any_of(s.begin(), s.end(), isdigit))) {  // looks like a number.
-    return NumberElement::parse(s);
-  } else if (starts_with(
-                 s,
-                 string(1,
-                        StringElement::QUOTE_CHAR))) {  // starts with a quote
-    return StringElement::parse(s);
-  } else if (starts_with(s, SubstackElement::SUBSTACK_BEGIN) &&
-             ends_with(
-                 s,
-                 SubstackElement::SUBSTACK_END)) {  // has a pair of substack
-                                                    // delmiters on either end
-                                                    // - must be a substack.
-    return SubstackElement::parse(s);
-  } else if (s == BooleanElement::TSTR ||
-             s == BooleanElement::FSTR) {  // it's either true or false
-    return new BooleanElement(s == string(BooleanElement::TSTR));
-  } else if (s.find_first_of(TypeElement::PARENS) != string::npos ||
-             find(TypeElement::TYPES().begin(), TypeElement::TYPES().end(),
-                  s) != TypeElement::TYPES()
-                            .end()) {  // has a subtype, or exists in types
-    return TypeElement::parse(s);
-  } else if (isalpha(s[0]) ||
-             (s[0] == IdentifierElement::QUOTE_CHAR && s.length() >= 2 &&
-              isalpha(s[1]))) {  // starts with a character
-    return IdentifierElement::parse(s);
-  } else {  // error case
-    throw ParserException(
-        "Input doesn't look like any type - does it begin with a symbol?", s,
-        0);
-  }
-}  // namespace stacklang
+  return Lexer(s).parseElement();
+}
+
+StackElement::~StackElement() { liveCount--; }
+
+size_t StackElement::getAllocationCount() noexcept { return allocationCount; }
 
-StackElement::~StackElement() = default;
+size_t StackElement::getLiveCount() noexcept { return liveCount; }
 
 StackElement::DataType StackElement::getType() const noexcept {
   return dataType;
 }
 
-StackElement::StackElement(DataType type) noexcept : dataType(type) {}
+StackElement::StackElement(DataType type) noexcept
+    : dataType(type), refCount(0) {
+  allocationCount++;
+  liveCount++;
+}
+
+StackElement::StackElement(const StackElement& other) noexcept
+    : dataType(other.dataType), refCount(0) {
+  allocationCount++;
+  liveCount++;
+}
+
+StackElement::StackElement(StackElement&& other) noexcept
+    : dataType(other.dataType), refCount(0) {
+  allocationCount++;
+  liveCount++;
+}
+
+StackElement& StackElement::operator=(const StackElement& other) noexcept {
+  dataType = other.dataType;
+  return *this;
+}
+
+StackElement& StackElement::operator=(StackElement&& other) noexcept {
+  dataType = other.dataType;
+  return *this;
+}
+
+Value::Value() noexcept : element(nullptr), precision(0), kind(Kind::Empty) {}
+
+Value::Value(long double num, int prec) noexcept
+    : number(num), precision(prec), kind(Kind::Number) {}
+
+Value::Value(StackElement::DataType type) noexcept
+    : base(type), precision(0), kind(Kind::Type) {}
+
+Value::Value(const StackElement* elm) noexcept : Value() {
+  if (elm == nullptr) return;
+
+  switch (elm->getType()) {
+    case StackElement::DataType::Number: {
+      const NumberElement* num = static_cast<const NumberElement*>(elm);
+      number = num->getData();
+      precision = num->getPrecision();
+      kind = Kind::Number;
+      break;
+    }
+    case StackElement::DataType::Boolean: {
+      boolean = static_cast<const BooleanElement*>(elm)->getData();
+      kind = Kind::Boolean;
+      break;
+    }
+    case StackElement::DataType::Type: {
+      const TypeElement* type = static_cast<const TypeElement*>(elm);
+      if (type->getSpecialization() == nullptr) {
+        base = type->getBase();
+        kind = Kind::Type;
+        break;
+      }
+      [[fallthrough]];
+    }
+    default: {
+      element = elm;
+      kind = Kind::Boxed;
+      elm->refCount++;
+      return;
+    }
+  }
+
+  if (elm->refCount == 0) delete elm;  // unboxed a fresh element
+}
+
+Value::Value(const Value& other) noexcept : Value() {
+  if (other.kind == Kind::Boxed) other.element->refCount++;
+  assign(other);
+}
+
+Value::Value(Value&& other) noexcept : Value() {
+  assign(other);
+  other.kind = Kind::Empty;
+}
 
-Stack::Stack(size_t lim) noexcept : head(nullptr), dataSize(0), limit(lim) {}
+Value::~Value() noexcept { release(); }
+
+Value& Value::operator=(const Value& other) noexcept {
+  if (other.kind == Kind::Boxed) other.element->refCount++;
+  release();
+  assign(other);
+  return *this;
+}
 
-Stack::Stack(initializer_list<StackElement*> initList) noexcept
-    : head(nullptr), dataSize(0), limit(numeric_limits<size_t>().max()) {
-  for (StackElement* elm : initList) {
-    push(elm);
+Value& Value::operator=(Value&& other) noexcept {
+  if (this == &other) return *this;
+  release();
+  assign(other);
+  other.kind = Kind::Empty;
+  return *this;
+}
+
+StackElement::DataType Value::getType() const noexcept {
+  switch (kind) {
+    case Kind::Number:
+      return StackElement::DataType::Number;
+    case Kind::Boolean:
+      return StackElement::DataType::Boolean;
+    case Kind::Type:
+      return StackElement::DataType::Type;
+    case Kind::Boxed:
+      return element->getType();
+    default:
+      return StackElement::DataType::Any;
   }
 }
 
-Stack::~Stack() noexcept { clear(); }
+long double Value::getNumber() const noexcept { return number; }
+
+int Value::getPrecision() const noexcept { return precision; }
+
+bool Value::getBoolean() const noexcept { return boolean; }
+
+StackElement::DataType Value::getBase() const noexcept {
+  return kind == Kind::Boxed
+             ? static_cast<const TypeElement*>(element)->getBase()
+             : base;
+}
+
+const TypeElement* Value::getSpecialization() const noexcept {
+  return kind == Kind::Boxed
+             ? static_cast<const TypeElement*>(element)->getSpecialization()
+             : nullptr;
+}
+
+const StackElement* Value::get() const noexcept {
+  return kind == Kind::Boxed ? element : nullptr;
+}
+
+ElementPtr Value::box() const {
+  switch (kind) {
+    case Kind::Number:
+      return new NumberElement(number, precision);
+    case Kind::Boolean:
+      return new BooleanElement(boolean);
+    case Kind::Type:
+      return new TypeElement(base);
+    case Kind::Boxed:
+      return element;
+    default:
+      return nullptr;
+  }
+}
+
+Value::operator bool() const noexcept { return kind != Kind::Empty; }
+
+Value::operator string() const noexcept {
+  switch (kind) {
+    case Kind::Number:
+      return NumberElement::to_string(number, precision);
+    case Kind::Boolean:
+      return boolean ? BooleanElement::TSTR : BooleanElement::FSTR;
+    case Kind::Type:
+      return TypeElement::to_string(base);
+    case Kind::Boxed:
+      return static_cast<string>(*element);
+    default:
+      return "";
+  }
+}
+
+bool Value::operator==(const Value& other) const noexcept {
+  if (kind != other.kind) return false;
+
+  switch (kind) {
+    case Kind::Number:
+      return number == other.number && precision == other.precision;
+    case Kind::Boolean:
+      return boolean == other.boolean;
+    case Kind::Type:
+      return base == other.base;
+    case Kind::Boxed:
+      return *element == *other.element;
+    default:
+      return true;
+  }
+}
+
+bool Value::operator!=(const Value& other) const noexcept {
+  return !(*this == other);
+}
+
+void Value::assign(const Value& other) noexcept {
+  switch (other.kind) {
+    case Kind::Number:
+      number = other.number;
+      break;
+    case Kind::Boolean:
+      boolean = other.boolean;
+      break;
+    case Kind::Type:
+      base = other.base;
+      break;
+    case Kind::Boxed:
+      element = other.element;
+      break;
+    default:
+      break;
+  }
+  precision = other.precision;
+  kind = other.kind;
+}
+
+void Value::release() noexcept {
+  if (kind == Kind::Boxed && --element->refCount == 0) delete element;
+  kind = Kind::Empty;
+}
+
+// Holds every element stored in it, including those past the top of the
+// stacks sharing it.
+struct Stack::Buffer {
+  vector<Value> elms;
+};
+
+Stack::Stack(size_t lim) noexcept : length(0), limit(lim) {}
+
+Stack::Stack(initializer_list<Value> initList) noexcept
+    : buffer(make_shared<Buffer>()),
+      length(initList.size()),
+      limit(numeric_limits<size_t>().max()) {
+  buffer->elms.assign(initList.begin(), initList.end());
+}
+
+Stack::~Stack() noexcept = default;
 
 Stack::Stack(const Stack& other) noexcept
-    : head(copy(other.head)), dataSize(other.dataSize), limit(other.limit) {}
+    : buffer(other.buffer), length(other.length), limit(other.limit) {}
 
-Stack::Stack(Stack&& other) noexcept {
-  head = other.head;
-  dataSize = other.dataSize;
-  limit = other.limit;
-  other.head = nullptr;
+Stack::Stack(Stack&& other) noexcept
+    : buffer(move(other.buffer)), length(other.length), limit(other.limit) {
+  other.length = 0;
 }
 
 Stack& Stack::operator=(const Stack& other) noexcept {
-  clear();
-  head = copy(other.head);
-  dataSize = other.dataSize;
+  buffer = other.buffer;
+  length = other.length;
   limit = other.limit;
   return *this;
 }
 
 Stack& Stack::operator=(Stack&& other) noexcept {
-  clear();
-  head = other.head;
-  dataSize = other.dataSize;
+  if (this == &other) return *this;
+  buffer = move(other.buffer);
+  length = other.length;
   limit = other.limit;
-  other.head = nullptr;
+  other.length = 0;
   return *this;
 }
 
-void Stack::push(StackElement* ptr) {
-  if (dataSize >= limit) {
+void Stack::push(Value value) {
+  if (length >= limit) {
     throw StackOverflowError(limit);
   }
 
-  head = new Node(ptr, head);
-  dataSize++;
+  if (buffer == nullptr || length != buffer->elms.size() ||
+      (buffer.use_count() != 1 &&
+       buffer->elms.size() == buffer->elms.capacity())) {
+    makeUnique();
+  }  // else appending in place - other stacks can't see the new element, and
+     // their references into the buffer stay valid
+
+  buffer->elms.push_back(move(value));
+  length++;
 }
 
-StackElement* Stack::pop() {
-  if (head != nullptr) {
-    StackElement* retval = head->elm.release();
-    Node* temp = head->next;
-    delete head;
-    head = temp;
-    dataSize--;
-    return retval;
+Value Stack::pop() {
+  if (length == 0) {
+    throw StackUnderflowError();
+  }
+
+  if (buffer.use_count() != 1) {
+    return buffer->elms[--length];
+  }
+
+  buffer->elms.resize(length);
+  Value retval = move(buffer->elms.back());
+  buffer->elms.pop_back();
+  length--;
+  return retval;
+}
+
+void Stack::drop() {
+  if (length == 0) {
+    throw StackUnderflowError();
+  }
+
+  length--;
+  if (buffer.use_count() == 1) buffer->elms.resize(length);
+}
+
+const Value& Stack::top() const {
+  if (length != 0) {
+    return buffer->elms[length - 1];
   }
 
   throw StackUnderflowError();
 }
 
-const StackElement* Stack::top() {
-  if (head != nullptr) {
-    return head->elm.get();
+const Value& Stack::operator[](size_t index) const noexcept {
+  return buffer->elms[length - 1 - index];
+}
+
+const Value& Stack::at(size_t index) const {
+  if (index < length) {
+    return buffer->elms[length - 1 - index];
   }
 
   throw StackUnderflowError();
 }
 
-size_t Stack::size() const noexcept { return dataSize; }
+void Stack::rotate(size_t n, size_t count) {
+  if (n > length) {
+    throw StackUnderflowError();
+  } else if (n <= 1 || count % n == 0) {
+    return;
+  }
+
+  makeUnique();
+  auto first = buffer->elms.end() - static_cast<ptrdiff_t>(n);
+  std::rotate(first, first + static_cast<ptrdiff_t>(count % n),
+              buffer->elms.end());
+}
+
+size_t Stack::size() const noexcept { return length; }
 
 size_t Stack::getLimit() const noexcept { return limit; }
 
 void Stack::setLimit(size_t newLimit) {
-  if (dataSize > newLimit) {
+  if (length > newLimit) {
     throw StackOverflowError(newLimit);
   }
 
   limit = newLimit;
 }
 
+void Stack::reserve(size_t capacity) {
+  makeUnique();
+  buffer->elms.reserve(capacity);
+}
+
 void Stack::reverse() noexcept {
-  queue<StackElement*> s;
-  while (!isEmpty()) {
-    s.push(pop());
-  }
-  while (!s.empty()) {
-    push(s.front());
-    s.pop();
-  }
+  if (length < 2) return;
+
+  makeUnique();
+  std::reverse(buffer->elms.begin(), buffer->elms.end());
 }
 
-bool Stack::isEmpty() const noexcept { return dataSize == 0; }
+bool Stack::isEmpty() const noexcept { return length == 0; }
 
 Stack::StackIterator Stack::begin() const noexcept {
-  return StackIterator(head);
+  return StackIterator(this, 0);
 }
 
 Stack::StackIterator Stack::end() const noexcept {
-  return StackIterator(nullptr);
+  return StackIterator(this, length);
 }
 
 void Stack::clear() noexcept {
-  while (head != nullptr) {
-    Node* temp = head->next;
-    delete head;
-    head = temp;
+  if (buffer.use_count() == 1) {
+    buffer->elms.clear();
+  } else {
+    buffer.reset();
   }
 
-  dataSize = 0;
+  length = 0;
 }
 
-Stack::Node* Stack::copy(Node* other) noexcept {
-  if (other == nullptr) {
-    return nullptr;
+void Stack::makeUnique() {
+  if (buffer == nullptr) {
+    buffer = make_shared<Buffer>();
+  } else if (buffer.use_count() != 1) {
+    shared_ptr<Buffer> copy = make_shared<Buffer>();
+    copy->elms.assign(buffer->elms.begin(),
+                      buffer->elms.begin() + static_cast<ptrdiff_t>(length));
+    buffer = move(copy);
   } else {
-    return new Node(other->elm->clone(), copy(other->next));
+    buffer->elms.resize(length);
   }
 }
 
-Stack::Node::Node(StackElement* ptr, Node* nxt) noexcept
-    : elm(ptr), next(nxt) {}
-
-Stack::StackIterator::StackIterator(const Stack::Node* node) noexcept
-    : curr(node) {}
+Stack::StackIterator::StackIterator(const Stack* s, size_t i) noexcept
+    : stack(s), index(i) {}
 
-const StackElement* Stack::StackIterator::operator*() noexcept {
-  return curr->elm.get();
+const Value& Stack::StackIterator::operator*() noexcept {
+  return (*stack)[index];
 }
 
 Stack::StackIterator& Stack::StackIterator::operator++() noexcept {
-  if (curr != nullptr) {
-    curr = curr->next;
-  }
-
+  index++;
   return *this;
 }
 
@@ -254,7 +479,7 @@ Stack::StackIterator Stack::StackIterator::operator++(int) noexcept {
 
 bool operator==(const Stack::StackIterator& first,
                 const Stack::StackIterator& second) noexcept {
-  return first.curr == second.curr;
+  return first.stack == second.stack && first.index == second.index;
 }
 
 bool operator!=(const Stack::StackIterator& first,
@@ -17,19 +17,32 @@
 // the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
 
 // Central data stack (not using STL stack because we are working with a
-// polymorphic pointer). Also includes iterator and base element declaration.
+// polymorphic pointer, and need random access). Also includes iterator and base
+// element declaration.
 
 #ifndef STACKLANG_LANGUAGE_STACK_H_
 #define STACKLANG_LANGUAGE_STACK_H_
 
+#include <atomic>
+#include <cstddef>
 #include <initializer_list>
 #include <limits>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace stacklang {
+namespace stackelements {
+class TypeElement;
+}
 
 // Represents a element in the stack. Subclassed to make a specific element.
+//
+// Elements are immutable once constructed, and are shared (through RefPtr)
+// instead of being copied. An element is deleted when the last RefPtr to it
+// goes away, so elements must always be allocated with new.
 class StackElement {
  public:
   static const int NUM_PRIM_TYPES;
@@ -49,12 +62,15 @@ class StackElement {
   // Produces a StackElement (of some type) from a terminal input string
   static StackElement* parse(const std::string&);
 
-  StackElement(const StackElement&) = default;
-  StackElement(StackElement&&) = default;
-  virtual StackElement* clone() const noexcept = 0;
+  // Counts of elements constructed so far, and of those still alive.
+  static size_t getAllocationCount() noexcept;
+  static size_t getLiveCount() noexcept;
+
+  StackElement(const StackElement&) noexcept;
+  StackElement(StackElement&&) noexcept;
 
-  StackElement& operator=(const StackElement&) = default;
-  StackElement& operator=(StackElement&&) = default;
+  StackElement& operator=(const StackElement&) noexcept;
+  StackElement& operator=(StackElement&&) noexcept;
 
   virtual ~StackElement() = 0;
 
@@ -80,20 +96,182 @@ class StackElement {
   explicit StackElement(DataType) noexcept;
 
   DataType dataType;
+
+ private:
+  template <typename T>
+  friend class RefPtr;
+  friend class Value;
+
+  mutable std::atomic<size_t> refCount;  // elements may be shared by threads
 };
 
-typedef std::unique_ptr<StackElement> ElementPtr;
+// Intrusive reference counted pointer to a StackElement (or subclass).
+// Converts implicitly to pointers to base classes, and explicitly to pointers
+// to derived classes (without checking - check the element's type first).
+template <typename T>
+class RefPtr {
+ public:
+  RefPtr() noexcept : ptr(nullptr) {}
+  RefPtr(std::nullptr_t) noexcept : ptr(nullptr) {}
+  RefPtr(T* p) noexcept : ptr(p) { acquire(); }
+  RefPtr(const RefPtr& other) noexcept : ptr(other.ptr) { acquire(); }
+  RefPtr(RefPtr&& other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+
+  template <typename U,
+            std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+  RefPtr(const RefPtr<U>& other) noexcept : ptr(other.get()) {
+    acquire();
+  }
+  template <typename U,
+            std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+  RefPtr(RefPtr<U>&& other) noexcept : ptr(other.get()) {
+    other.ptr = nullptr;
+  }
+  template <typename U,
+            std::enable_if_t<!std::is_convertible_v<U*, T*>, int> = 0>
+  explicit RefPtr(const RefPtr<U>& other) noexcept
+      : ptr(static_cast<T*>(other.get())) {
+    acquire();
+  }
+  template <typename U,
+            std::enable_if_t<!std::is_convertible_v<U*, T*>, int> = 0>
+  explicit RefPtr(RefPtr<U>&& other) noexcept
+      : ptr(static_cast<T*>(other.get())) {
+    other.ptr = nullptr;
+  }
+
+  ~RefPtr() noexcept { dispose(); }
+
+  RefPtr& operator=(RefPtr other) noexcept {
+    std::swap(ptr, other.ptr);
+    return *this;
+  }
+
+  T* get() const noexcept { return ptr; }
+  T& operator*() const noexcept { return *ptr; }
+  T* operator->() const noexcept { return ptr; }
+  explicit operator bool() const noexcept { return ptr != nullptr; }
+  bool operator==(std::nullptr_t) const noexcept { return ptr == nullptr; }
+  bool operator!=(std::nullptr_t) const noexcept { return ptr != nullptr; }
+
+  // Number of RefPtrs sharing the element
+  size_t useCount() const noexcept {
+    return ptr == nullptr ? 0 : ptr->refCount.load();
+  }
 
-// A literal stack of StackElements.
-class Stack {
-  struct Node;
+ private:
+  template <typename U>
+  friend class RefPtr;
+
+  void acquire() noexcept {
+    if (ptr != nullptr) ptr->refCount++;
+  }
+  void dispose() noexcept {
+    if (ptr != nullptr && --ptr->refCount == 0) delete ptr;
+  }
+
+  T* ptr;
+};
+
+typedef RefPtr<const StackElement> ElementPtr;
+
+// A single slot of a stack. Numbers, booleans and unspecialized types are
+// stored inline, so producing them never allocates. Everything else is boxed:
+// the value holds a reference to a shared StackElement.
+//
+// Constructing a value from a Number, Boolean or unspecialized Type element
+// unboxes it (and deletes the element if nothing else refers to it), so each
+// kind of data has exactly one representation.
+class Value {
+ public:
+  Value() noexcept;  // an empty value, which has no type
+  explicit Value(
+      long double,
+      int = std::numeric_limits<long double>::max_digits10) noexcept;
+  template <typename B,
+            std::enable_if_t<std::is_same_v<B, bool>, int> = 0>
+  explicit Value(B b) noexcept
+      : boolean(b), precision(0), kind(Kind::Boolean) {}
+  explicit Value(StackElement::DataType) noexcept;  // an unspecialized type
+  Value(const StackElement*) noexcept;
+  template <typename T,
+            std::enable_if_t<std::is_convertible_v<T*, const StackElement*>,
+                             int> = 0>
+  Value(const RefPtr<T>& ptr) noexcept : Value(ptr.get()) {}
+  Value(const Value&) noexcept;
+  Value(Value&&) noexcept;
+
+  ~Value() noexcept;
+
+  Value& operator=(const Value&) noexcept;
+  Value& operator=(Value&&) noexcept;
+
+  StackElement::DataType getType() const noexcept;
+
+  // Data of inline values - only valid for values of the matching type.
+  long double getNumber() const noexcept;
+  int getPrecision() const noexcept;
+  bool getBoolean() const noexcept;
+
+  // Base and specialization of a Type value.
+  StackElement::DataType getBase() const noexcept;
+  const stackelements::TypeElement* getSpecialization() const noexcept;
+
+  // The boxed element, or nullptr if the value is stored inline.
+  const StackElement* get() const noexcept;
+
+  // Produces an element holding this value, allocating one if the value is
+  // stored inline.
+  ElementPtr box() const;
+
+  // Converts to a pointer to the given element type. Check the type first.
+  template <typename T>
+  explicit operator RefPtr<T>() const {
+    return RefPtr<T>(static_cast<T*>(box().get()));
+  }
+
+  explicit operator bool() const noexcept;
+  explicit operator std::string() const noexcept;
+
+  bool operator==(const Value&) const noexcept;
+  bool operator!=(const Value&) const noexcept;
+
+ private:
+  enum class Kind : unsigned char { Empty, Number, Boolean, Type, Boxed };
+
+  // Copies the data of another value, without touching reference counts.
+  void assign(const Value&) noexcept;
+  void release() noexcept;
+
+  union {
+    long double number;
+    bool boolean;
+    StackElement::DataType base;
+    const StackElement* element;
+  };
+  int precision;
+  Kind kind;
+};
 
+// A literal stack of Values. Values are stored contiguously, with the top of
+// the stack at the end of the buffer.
+//
+// Copies of a stack share the buffer, and each copy sees its own prefix of it.
+// Pushing onto a copy that reaches the end of the buffer appends in place if
+// the buffer has room, so copying a stack and pushing or popping a few elements
+// costs O(1). Stacks that have to modify a shared part of the buffer, or grow a
+// shared buffer, copy their prefix first, so references one copy got from top,
+// at, operator[] or an iterator stay valid while other copies are modified.
+// Modifying the stack itself may still invalidate them. Boxed elements are
+// immutable and reference counted, so copying a prefix never copies an
+// element.
+class Stack {
  public:
   class StackIterator;
 
   // Creates a stack, optionally with a limit on the number of elements.
   explicit Stack(size_t = std::numeric_limits<size_t>().max()) noexcept;
-  explicit Stack(std::initializer_list<StackElement*>) noexcept;
+  explicit Stack(std::initializer_list<Value>) noexcept;
   Stack(const Stack&) noexcept;
   Stack(Stack&&) noexcept;
 
@@ -102,12 +280,22 @@ class Stack {
   Stack& operator=(const Stack&) noexcept;
   Stack& operator=(Stack&&) noexcept;
 
-  // Manipulates stack elements. Pop does not delete the element, but the stack
-  // destructor does assume that when the stack is destroyed, it's managed
-  // elements should be deallocated.
-  void push(StackElement*);
-  StackElement* pop();
-  const StackElement* top();
+  // Manipulates stack elements. Drop discards the top element.
+  void push(Value);
+  Value pop();
+  void drop();
+  const Value& top() const;
+
+  // Random access to elements, counting down from the top of the stack (the
+  // top element has index zero). Operator[] does not check bounds, at throws
+  // StackUnderflowError if the index is past the bottom of the stack.
+  const Value& operator[](size_t) const noexcept;
+  const Value& at(size_t) const;
+
+  // Moves the element at depth n (the top element has depth 1) to the top of
+  // the stack, count times. Throws StackUnderflowError if there are fewer than
+  // n elements.
+  void rotate(size_t n, size_t count = 1);
 
   void clear() noexcept;
 
@@ -120,20 +308,22 @@ class Stack {
   // Sets a new limit. Throws StackOverflowError if too big.
   void setLimit(size_t);
 
+  // Reserves space for at least the given number of elements.
+  void reserve(size_t);
+
   void reverse() noexcept;
 
   bool isEmpty() const noexcept;
 
  private:
-  struct Node {
-    std::unique_ptr<StackElement> elm;
-    Node* next;
-    Node(StackElement*, Node*) noexcept;
-  };
-  Node* copy(Node*) noexcept;
+  struct Buffer;
+
+  // Ensures that this stack is the only one using its buffer, and that the
+  // buffer holds no elements past the top of this stack.
+  void makeUnique();
 
-  Node* head;
-  size_t dataSize;
+  std::shared_ptr<Buffer> buffer;  // null until the first push
+  size_t length;
   size_t limit;
 };
 
@@ -141,13 +331,13 @@ class Stack {
 class Stack::StackIterator {
  public:
   typedef size_t difference_type;
-  typedef const StackElement* value_type;
-  typedef const StackElement** pointer;
-  typedef const StackElement*& reference;
+  typedef Value value_type;
+  typedef const Value* pointer;
+  typedef const Value& reference;
   typedef size_t size_type;
   typedef std::input_iterator_tag iterator_category;
 
-  explicit StackIterator(const Stack::Node*) noexcept;
+  StackIterator(const Stack*, size_t) noexcept;
   StackIterator(const StackIterator&) = default;
 
   StackIterator& operator=(const StackIterator&) = default;
@@ -157,13 +347,14 @@ class Stack::StackIterator {
   friend bool operator!=(const Stack::StackIterator&,
                          const Stack::StackIterator&) noexcept;
 
-  const StackElement* operator*() noexcept;
+  const Value& operator*() noexcept;
 
   StackIterator& operator++() noexcept;
   StackIterator operator++(int) noexcept;
 
  private:
-  const Stack::Node* curr;
+  const Stack* stack;
+  size_t index;  // counted from the top - stays valid if the buffer grows
 };
 
 bool operator==(const Stack::StackIterator&,
@@ -20,41 +20,29 @@
 
 #include "language/stack/stackElements.h"
 
-#include <algorithm>
 #include <iomanip>
 #include <limits>
 #include <sstream>
 #include <string>
 #include <utility>
 
-#include "language/exceptions/interpreterExceptions.h"
 #include "language/language.h"
+#include "language/primitives.h"
+#include "language/stack/lexer.h"
 #include "util/stringUtils.h"
 
 namespace stacklang::stackelements {
 namespace {
-using stacklang::exceptions::ParserException;
-using stacklang::exceptions::StackOverflowError;
-using stacklang::exceptions::StackUnderflowError;
-using std::count;
 using std::fixed;
 using std::make_unique;
+using std::move;
 using std::numeric_limits;
-using std::pair;
 using std::setprecision;
 using std::stold;
 using std::string;
 using std::stringstream;
-using std::swap;
 using std::to_string;
-using std::vector;
-using util::ends_with;
 using util::escape;
-using util::findImproperEscape;
-using util::removeChar;
-using util::starts_with;
-using util::trim;
-using util::unescape;
 }  // namespace
 
 const char* const BooleanElement::TSTR = "true";
@@ -63,10 +51,6 @@ const char* const BooleanElement::FSTR = "false";
 BooleanElement::BooleanElement(bool b) noexcept
     : StackElement(StackElement::DataType::Boolean), data(b) {}
 
-BooleanElement* BooleanElement::clone() const noexcept {
-  return new BooleanElement(data);
-}
-
 bool BooleanElement::operator==(const StackElement& elm) const noexcept {
   if (elm.getType() != dataType) {
     return false;
@@ -91,119 +75,72 @@ bool CommandElement::operator==(const StackElement& elm) const noexcept {
 
 const char* const PrimitiveCommandElement::DISPLAY_AS = "<PRIMITIVE>";
 
-PrimitiveCommandElement::PrimitiveCommandElement(
-    std::function<void(Stack&, Environment*)> p) noexcept
-    : CommandElement{true}, fun{p} {}
-PrimitiveCommandElement* PrimitiveCommandElement::clone() const noexcept {
-  return new PrimitiveCommandElement(fun);
-}
+PrimitiveCommandElement::PrimitiveCommandElement(size_t op) noexcept
+    : CommandElement{true}, opcode{op} {}
 
 PrimitiveCommandElement::operator std::string() const noexcept {
   return DISPLAY_AS;
 }
 
-void PrimitiveCommandElement::operator()(Stack& s, Environment* e) const {
-  fun(s, e);
+void PrimitiveCommandElement::operator()(Stack& s, const Scope& e) const {
+  PRIMITIVES[opcode].fun(s, e);
 }
 
+size_t PrimitiveCommandElement::getOpcode() const noexcept { return opcode; }
+
 const char* const DefinedCommandElement::DISPLAY_AS = "<FUNCTION>";
 
 DefinedCommandElement::DefinedCommandElement(const Stack& p, const Stack& s,
                                              const Stack& b,
-                                             Environment* e) noexcept
-    : CommandElement{false}, params{p}, sig{s}, body{b}, env{e} {}
-DefinedCommandElement* DefinedCommandElement::clone() const noexcept {
-  return new DefinedCommandElement(params, sig, body, env);
-}
+                                             Environment* e)
+    : CommandElement{false},
+      params{p},
+      sig{s},
+      body{b},
+      env{e},
+      code{p, b, e} {}
 
 DefinedCommandElement::operator std::string() const noexcept {
   return DISPLAY_AS;
 }
 
-void DefinedCommandElement::operator()(Stack& mainStack) {
+void DefinedCommandElement::bind(Stack& mainStack, Value* slots) const {
   checkTypes(mainStack, sig);
 
-  for (const auto& elm : params) {
-    env->bindings.insert(pair<string, StackElement*>(
-        dynamic_cast<const IdentifierElement*>(elm)->getName(),
-        mainStack.pop()));
-  }
-
-  for (const auto& elm : body) {
-    try {
-      mainStack.push(elm->clone());
-    } catch (const StackOverflowError& exn) {
-      // stack error without trace must be main stack.
-      if (exn.getTrace().empty()) {
-        throw StackOverflowError(mainStack.getLimit());
-      } else {
-        throw;
-      }
-    } catch (const StackUnderflowError& exn) {
-      if (exn.getTrace().empty()) {
-        throw StackUnderflowError();
-      } else {
-        throw;
-      }
-    }
-    execute(mainStack, env);
-  }
+  for (size_t i = 0; i < env->params.size(); i++) slots[i] = mainStack.pop();
+}
 
-  env->clearBindings();
+Environment* DefinedCommandElement::getEnv() const noexcept { return env; }
 
-  return execute(mainStack, env);
+const Bytecode& DefinedCommandElement::getCode() const noexcept {
+  return code;
 }
 
-Environment* DefinedCommandElement::getEnv() noexcept { return env; }
+const Stack& DefinedCommandElement::getParams() const noexcept {
+  return params;
+}
 
-Stack& DefinedCommandElement::getSig() noexcept { return sig; }
+const Stack& DefinedCommandElement::getSig() const noexcept { return sig; }
 
-Stack& DefinedCommandElement::getBody() noexcept { return body; }
+const Stack& DefinedCommandElement::getBody() const noexcept { return body; }
 
 const char* const IdentifierElement::ALLOWED_IDENTIFIER =
     "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890-?*";
 const char IdentifierElement::QUOTE_CHAR = '`';
 
 IdentifierElement* IdentifierElement::parse(const string& s) {
-  if (s.find_first_not_of(IdentifierElement::ALLOWED_IDENTIFIER, 1) ==
-          string::npos &&
-      (isalpha(s[0]) ||
-       (s[0] == QUOTE_CHAR && s.length() >= 2 &&
-        isalpha(s[1])))) {  // has only allowed characters, starts with a
-                            // quote char and a letter or a letter
-    return new IdentifierElement(removeChar(s, QUOTE_CHAR), s[0] == QUOTE_CHAR);
-  } else {
-    size_t badIndex = s.find_first_not_of(IdentifierElement::ALLOWED_IDENTIFIER,
-                                          s[0] == QUOTE_CHAR ? 1 : 0);
-    if (badIndex == string::npos) {
-      if (!(isalpha(s[0]) || ((s[0] == QUOTE_CHAR && isalpha(s[1]))))) {
-        throw ParserException(
-            "Input does not begin with an alphabetic character.", s,
-            s[0] == QUOTE_CHAR ? 1 : 0);
-      } else {
-        throw ParserException("Input is too short.", s,
-                              s[0] == QUOTE_CHAR ? 2 : 1);
-      }
-    } else if (s[badIndex] == ' ') {  // has a space
-      throw ParserException("Input looks like a command, but has a space.", s,
-                            badIndex);
-    } else {
-      throw ParserException(
-          "Input looks like a command, but has a symbol "
-          "that is not in `-?*`.",
-          s, badIndex);
-    }
-  }
+  return Lexer(s).parseIdentifier();
 }
 
-IdentifierElement::IdentifierElement(const string& s, bool isQuoted) noexcept
+IdentifierElement::IdentifierElement(const string& s, bool isQuoted)
     : StackElement(StackElement::DataType::Identifier),
       name(s),
       quoted(isQuoted) {}
 
-IdentifierElement* IdentifierElement::clone() const noexcept {
-  return new IdentifierElement(name, quoted);
-}
+IdentifierElement::IdentifierElement(Symbol s, bool isQuoted) noexcept
+    : StackElement(StackElement::DataType::Identifier),
+      name(s),
+      quoted(isQuoted) {}
 
 bool IdentifierElement::operator==(const StackElement& elm) const noexcept {
   if (elm.getType() != dataType) {
@@ -215,39 +152,20 @@ bool IdentifierElement::operator==(const StackElement& elm) const noexcept {
 }
 
 IdentifierElement::operator string() const noexcept {
-  return (quoted ? string(1, QUOTE_CHAR) : "") + name;
+  return (quoted ? string(1, QUOTE_CHAR) : "") + name.getName();
 }
 
-const string& IdentifierElement::getName() const noexcept { return name; }
+const string& IdentifierElement::getName() const noexcept {
+  return name.getName();
+}
+Symbol IdentifierElement::getSymbol() const noexcept { return name; }
 bool IdentifierElement::isQuoted() const noexcept { return quoted; }
 
 const char* const NumberElement::ALLOWED_NUMBER = "-+1234567890.'";
 const char* const NumberElement::NUMBER_SIGNS = "-+";
 
 NumberElement* NumberElement::parse(const string& s) {
-  if (s.find_first_not_of(ALLOWED_NUMBER) ==
-      string::npos) {                           // has allowed chars
-    if (count(s.begin(), s.end(), '.') <= 1) {  // only one dot or decimal point
-      if (s.find_last_of(NUMBER_SIGNS) == 0 ||
-          s.find_last_of(NumberElement::NUMBER_SIGNS) ==
-              string::npos) {  // sign is first, second but has a tilde
-                               // before it, or doesn't exist
-        return new NumberElement(removeChar(s, '\''));
-      } else {
-        throw ParserException(
-            "Looks like a number, but has a sign in the middle.", s,
-            s.find_last_of(NUMBER_SIGNS));
-      }
-    } else {
-      throw ParserException(
-          "Looks like a number, but has more than one deminal point.", s,
-          s.find('.', s.find('.') + 1));
-    }
-  } else {
-    throw ParserException(
-        "Looks like a number, but has an unexpected character.", s,
-        s.find_first_not_of(NumberElement::ALLOWED_NUMBER));
-  }
+  return Lexer(s).parseNumber();
 }
 
 NumberElement::NumberElement(long double num, int prec) noexcept
@@ -261,10 +179,6 @@ NumberElement::NumberElement(string d) noexcept
       d.find('.') == string::npos ? 0 : d.substr(d.find('.') + 1).length();
 }
 
-NumberElement* NumberElement::clone() const noexcept {
-  return new NumberElement(data, precision);
-}
-
 bool NumberElement::operator==(const StackElement& elm) const noexcept {
   if (elm.getType() != dataType) {
     return false;
@@ -275,38 +189,27 @@ bool NumberElement::operator==(const StackElement& elm) const noexcept {
 }
 
 NumberElement::operator string() const noexcept {
-  stringstream stream;
-  stream << fixed << setprecision(precision) << data;
-  return stream.str();
+  return to_string(data, precision);
 }
 
 long double NumberElement::getData() const noexcept { return data; }
 int NumberElement::getPrecision() const noexcept { return precision; }
 
+string NumberElement::to_string(long double num, int prec) noexcept {
+  stringstream stream;
+  stream << fixed << setprecision(prec) << num;
+  return stream.str();
+}
+
 const char StringElement::QUOTE_CHAR = '"';
 
 StringElement* StringElement::parse(const string& s) {
-  if (ends_with(s, "\"")) {  // has quotes on either end
-    if (findImproperEscape(s.substr(1, s.length() - 2)) == string::npos) {
-      return new StringElement(unescape(s.substr(1, s.length() - 2)));
-    } else {
-      throw ParserException(
-          "Looks like a string, but has an invalid escape sequence", s,
-          findImproperEscape(s.substr(1, s.length() - 2)) + 1);
-    }
-  } else {
-    throw ParserException(
-        "Looks like a string, but is missing a closing quote.", s, s.length());
-  }
+  return Lexer(s).parseString();
 }
 
 StringElement::StringElement(string s) noexcept
     : StackElement(StackElement::DataType::String), data(s) {}
 
-StringElement* StringElement::clone() const noexcept {
-  return new StringElement(data);
-}
-
 bool StringElement::operator==(const StackElement& elm) const noexcept {
   if (elm.getType() != dataType) {
     return false;
@@ -328,61 +231,7 @@ const char* const SubstackElement::SUBSTACK_SEPARATOR = ", ";
 const char* const SubstackElement::SUBSTACK_EMPTY = "<< (empty) >>";
 
 SubstackElement* SubstackElement::parse(const string& s) {
-  int parseLevel = 0;
-  bool inString = false;
-  bool setLastChar = true;
-  string accumulator = "";
-  char lastChar = '\0';
-  Stack buffer;
-
-  for (auto iter = s.begin() + 2; iter != s.end() - 2;
-       iter++) {  // loop between the << and >>'s
-    accumulator += *iter;
-
-    if (!inString && *iter == ',' &&
-        parseLevel == 0) {  // found a comma at top level - our responsibility
-      accumulator.erase(accumulator.end() - 1);  // remove the comma
-      buffer.push(StackElement::parse(trim(accumulator)));
-      accumulator = "";
-    } else if (*iter == '"' && lastChar != '\\') {  // found an unescaped quote
-      inString = !inString;
-    } else if (inString && *iter == '\\' &&
-               lastChar == '\\') {  // found an escaped backslash
-      lastChar = '\0';
-      setLastChar = false;
-    } else if (!inString && *iter == '<' &&
-               lastChar == '<') {  // start of substack
-      lastChar = '\0';
-      setLastChar = false;
-      parseLevel++;
-    } else if (!inString && *iter == '>' &&
-               lastChar == '>') {  // end of substack
-      lastChar = '\0';
-      setLastChar = false;
-      parseLevel--;
-      if (parseLevel < 0) {
-        throw ParserException(
-            "Missing at least one matching opening substack delimiter.", s,
-            static_cast<size_t>(iter - s.begin() - 1));
-      }
-    }
-
-    if (setLastChar) lastChar = *iter;
-    setLastChar = true;
-  }
-
-  if (parseLevel != 0) {
-    throw ParserException("Missing " + to_string(parseLevel) +
-                              " closing substack delimiter" +
-                              (parseLevel == 1 ? "" : "s") + ".",
-                          s, s.length() - 1);
-  } else if (trim(accumulator) !=
-             "") {  // allow empty lists and terminal commas
-    buffer.push(StackElement::parse(trim(accumulator)));
-  }
-
-  buffer.reverse();
-  return new SubstackElement(buffer);
+  return Lexer(s).parseSubstack();
 }
 
 SubstackElement::SubstackElement(const Stack& s) noexcept
@@ -390,10 +239,6 @@ SubstackElement::SubstackElement(const Stack& s) noexcept
   data.setLimit(numeric_limits<size_t>::max());
 }
 
-SubstackElement* SubstackElement::clone() const noexcept {
-  return new SubstackElement(data);
-}
-
 bool SubstackElement::operator==(const StackElement& elm) const noexcept {
   if (elm.getType() != dataType) {
     return false;
@@ -402,7 +247,7 @@ bool SubstackElement::operator==(const StackElement& elm) const noexcept {
     if (s.data.size() != data.size()) return false;
     auto iter1 = s.data.begin(), iter2 = data.begin();
     for (; iter2 != data.end(); ++iter1, ++iter2) {
-      if (!(**iter1 == **iter2)) return false;
+      if (*iter1 != *iter2) return false;
     }
     return true;
   }
@@ -415,8 +260,8 @@ SubstackElement::operator string() const noexcept {
   string buffer = SUBSTACK_BEGIN;
   buffer += " ";
 
-  for (auto elm : data) {
-    buffer += static_cast<string>(*elm);
+  for (const auto& elm : data) {
+    buffer += static_cast<string>(elm);
     buffer += SUBSTACK_SEPARATOR;
   }
 
@@ -430,78 +275,24 @@ SubstackElement::operator string() const noexcept {
 
 const Stack& SubstackElement::getData() const noexcept { return data; }
 
+Stack SubstackElement::take(RefPtr<const SubstackElement>& sub) noexcept {
+  Stack taken = sub.useCount() == 1
+                    ? move(const_cast<SubstackElement*>(sub.get())->data)
+                    : sub->data;
+  sub = nullptr;
+  return taken;
+}
+
 const char* const TypeElement::PARENS = "()";
 
 TypeElement* TypeElement::parse(const string& s) {
-  if (s.find('(') == string::npos) {
-    auto value = find(TYPES().begin(), TYPES().end(), s);
-    if (value == TYPES().end()) {
-      throw ParserException("Input is not a type.", s, 0);
-    }
-    return new TypeElement(static_cast<DataType>(value - begin(TYPES())));
-  } else if (starts_with(s, "Substack")) {  // substack specializations
-    return new TypeElement(
-        DataType::Substack,
-        TypeElement::parse(s.substr(s.find_first_of('(') + 1,
-                                    s.length() - s.find_first_of('(') - 2)));
-  } else if (starts_with(s, "Command")) {  // command specializations
-    return new TypeElement(
-        DataType::Command,
-        TypeElement::parse(s.substr(s.find_first_of('(') + 1,
-                                    s.length() - s.find_first_of('(') - 2)));
-  } else if (starts_with(s, "Identifier")) {  // identifier specializations
-    return new TypeElement(
-        DataType::Identifier,
-        TypeElement::parse(s.substr(s.find_first_of('(') + 1,
-                                    s.length() - s.find_first_of('(') - 2)));
-  } else {
-    throw ParserException(
-        "Cannot have a specialization except on a Substack, Command, or "
-        "Identifier.",
-        s, s.find('('));
-  }
-}  // namespace StackElements
-
-TypeElement::TypeElement(DataType type, TypeElement* subType) noexcept
-    : StackElement(StackElement::DataType::Type),
-      data(type),
-      specialization(subType) {}
-
-TypeElement::TypeElement(const TypeElement& other) noexcept
-    : StackElement(StackElement::DataType::Type), data(other.data) {
-  specialization =
-      other.specialization == nullptr ? nullptr : other.specialization->clone();
+  return Lexer(s).parseType();
 }
 
-TypeElement& TypeElement::operator=(const TypeElement& other) noexcept {
-  data = other.data;
-  if (specialization != nullptr) delete specialization;
-  specialization =
-      other.specialization == nullptr ? nullptr : other.specialization->clone();
-  return *this;
-}
-
-TypeElement::TypeElement(TypeElement&& other) noexcept
+TypeElement::TypeElement(DataType type, TypePtr subType) noexcept
     : StackElement(StackElement::DataType::Type),
-      data(other.data),
-      specialization(nullptr) {
-  swap(specialization, other.specialization);
-}
-
-TypeElement& TypeElement::operator=(TypeElement&& other) noexcept {
-  data = other.data;
-  swap(specialization, other.specialization);
-  return *this;
-}
-
-TypeElement::~TypeElement() noexcept {
-  if (specialization != nullptr) delete specialization;
-}
-
-TypeElement* TypeElement::clone() const noexcept {
-  return new TypeElement(
-      data, specialization == nullptr ? nullptr : specialization->clone());
-}
+      data(type),
+      specialization(move(subType)) {}
 
 bool TypeElement::operator==(const StackElement& elm) const noexcept {
   if (elm.getType() != dataType) {
@@ -524,17 +315,10 @@ TypeElement::operator string() const noexcept {
 
 StackElement::DataType TypeElement::getBase() const noexcept { return data; }
 const TypeElement* TypeElement::getSpecialization() const noexcept {
-  return specialization;
+  return specialization.get();
 }
 
 string TypeElement::to_string(StackElement::DataType type) noexcept {
-  return TYPES()[static_cast<size_t>(type)];
-}
-
-const vector<string>& TypeElement::TYPES() noexcept {
-  static vector<string>* TYPES = new vector<string>{
-      "Number",  "String",     "Boolean",   "Substack", "Type",
-      "Command", "Identifier", "Primitive", "Defined",  "Any"};
-  return *TYPES;
+  return string(TYPES[static_cast<size_t>(type)]);
 }
 }  // namespace stacklang::stackelements
\ No newline at end of file
@@ -21,17 +21,20 @@
 #ifndef STACKLANG_LANGUAGE_STACK_STACKELEMENT_H_
 #define STACKLANG_LANGUAGE_STACK_STACKELEMENT_H_
 
-#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "language/bytecode.h"
 #include "language/environment.h"
 #include "language/stack/stack.h"
+#include "language/stack/symbol.h"
 
 namespace stacklang {
+class Scope;
 
 namespace stackelements {
 
@@ -41,7 +44,6 @@ class BooleanElement : public StackElement {
   static const char* const FSTR;
 
   explicit BooleanElement(bool) noexcept;
-  BooleanElement* clone() const noexcept override;
 
   bool operator==(const StackElement&) const noexcept override;
 
@@ -67,15 +69,16 @@ class PrimitiveCommandElement : public CommandElement {
  public:
   static const char* const DISPLAY_AS;
 
-  PrimitiveCommandElement(std::function<void(Stack&, Environment*)>) noexcept;
-  PrimitiveCommandElement* clone() const noexcept override;
+  explicit PrimitiveCommandElement(size_t opcode) noexcept;
 
   explicit operator std::string() const noexcept override;
 
-  void operator()(Stack&, Environment*) const;
+  void operator()(Stack&, const Scope&) const;
+
+  size_t getOpcode() const noexcept;
 
  private:
-  std::function<void(Stack&, Environment*)> fun;
+  size_t opcode;  // index in PRIMITIVES
 };
 
 class DefinedCommandElement : public CommandElement {
@@ -83,22 +86,26 @@ class DefinedCommandElement : public CommandElement {
   static const char* const DISPLAY_AS;
 
   DefinedCommandElement(const Stack& params, const Stack& sig,
-                        const Stack& body, Environment* closure) noexcept;
-  DefinedCommandElement* clone() const noexcept override;
+                        const Stack& body, Environment* closure);
 
   explicit operator std::string() const noexcept override;
 
-  void operator()(Stack&);
+  // Checks the arguments on the stack against the signature and pops them
+  // into slots for the parameters. The body is run by execute.
+  void bind(Stack&, Value* slots) const;
 
-  Environment* getEnv() noexcept;
-  Stack& getSig() noexcept;
-  Stack& getBody() noexcept;
+  Environment* getEnv() const noexcept;
+  const Bytecode& getCode() const noexcept;
+  const Stack& getParams() const noexcept;
+  const Stack& getSig() const noexcept;
+  const Stack& getBody() const noexcept;
 
  private:
   Stack params;
   Stack sig;
   Stack body;
   Environment* env;
+  Bytecode code;
 };
 
 class IdentifierElement : public StackElement {
@@ -108,18 +115,18 @@ class IdentifierElement : public StackElement {
 
   static IdentifierElement* parse(const std::string&);
 
-  explicit IdentifierElement(const std::string&,
-                             bool isQuoted = false) noexcept;
-  IdentifierElement* clone() const noexcept override;
+  explicit IdentifierElement(const std::string&, bool isQuoted = false);
+  explicit IdentifierElement(Symbol, bool isQuoted = false) noexcept;
 
   bool operator==(const StackElement&) const noexcept override;
 
   explicit operator std::string() const noexcept override;
   const std::string& getName() const noexcept;
+  Symbol getSymbol() const noexcept;
   bool isQuoted() const noexcept;
 
  private:
-  std::string name;
+  Symbol name;
   bool quoted;
 };
 
@@ -134,7 +141,6 @@ class NumberElement : public StackElement {
       long double,
       int = std::numeric_limits<long double>::max_digits10) noexcept;
   explicit NumberElement(std::string) noexcept;
-  NumberElement* clone() const noexcept override;
 
   bool operator==(const StackElement&) const noexcept override;
 
@@ -142,6 +148,8 @@ class NumberElement : public StackElement {
   long double getData() const noexcept;
   int getPrecision() const noexcept;
 
+  static std::string to_string(long double, int) noexcept;
+
  private:
   long double data;
   int precision;
@@ -153,7 +161,6 @@ class StringElement : public StackElement {
 
   static StringElement* parse(const std::string&);
   explicit StringElement(std::string) noexcept;
-  StringElement* clone() const noexcept override;
 
   bool operator==(const StackElement&) const noexcept override;
 
@@ -168,13 +175,17 @@ class SubstackElement : public StackElement {
  public:
   static SubstackElement* parse(const std::string&);
   explicit SubstackElement(const Stack&) noexcept;
-  SubstackElement* clone() const noexcept override;
 
   bool operator==(const StackElement&) const noexcept override;
 
   explicit operator std::string() const noexcept override;
   const Stack& getData() const noexcept;
 
+  // Gives the data of the substack, and releases the pointer. If it was the
+  // only reference, nothing else can see the substack, so the data is moved
+  // out, and the stack given can be changed without copying its buffer.
+  static Stack take(RefPtr<const SubstackElement>&) noexcept;
+
   static const char* const SUBSTACK_BEGIN;
   static const char* const SUBSTACK_END;
 
@@ -189,13 +200,8 @@ class TypeElement : public StackElement {
  public:
   static TypeElement* parse(const std::string&);
 
-  explicit TypeElement(DataType, TypeElement* = nullptr) noexcept;
-  TypeElement(const TypeElement&) noexcept;
-  TypeElement& operator=(const TypeElement&) noexcept;
-  TypeElement(TypeElement&&) noexcept;
-  TypeElement& operator=(TypeElement&&) noexcept;
-  TypeElement* clone() const noexcept override;
-  ~TypeElement() noexcept;
+  explicit TypeElement(DataType,
+                       RefPtr<const TypeElement> = nullptr) noexcept;
 
   bool operator==(const StackElement&) const noexcept override;
 
@@ -205,24 +211,27 @@ class TypeElement : public StackElement {
 
   static std::string to_string(DataType) noexcept;
 
-  static const std::vector<std::string>& TYPES() noexcept;
+  // Names of the base types, indexed by DataType.
+  static constexpr std::string_view TYPES[] = {
+      "Number",  "String",     "Boolean",   "Substack", "Type",
+      "Command", "Identifier", "Primitive", "Defined",  "Any"};
 
   static const char* const PARENS;
 
  private:
   DataType data;
-  TypeElement* specialization;
+  RefPtr<const TypeElement> specialization;
 };
 
-typedef std::unique_ptr<BooleanElement> BooleanPtr;
-typedef std::unique_ptr<CommandElement> CommandPtr;
-typedef std::unique_ptr<NumberElement> NumberPtr;
-typedef std::unique_ptr<StringElement> StringPtr;
-typedef std::unique_ptr<SubstackElement> SubstackPtr;
-typedef std::unique_ptr<TypeElement> TypePtr;
-typedef std::unique_ptr<IdentifierElement> IdentifierPtr;
-typedef std::unique_ptr<DefinedCommandElement> DefinedCommandPtr;
-typedef std::unique_ptr<PrimitiveCommandElement> PrimitiveCommandPtr;
+typedef RefPtr<const BooleanElement> BooleanPtr;
+typedef RefPtr<const CommandElement> CommandPtr;
+typedef RefPtr<const NumberElement> NumberPtr;
+typedef RefPtr<const StringElement> StringPtr;
+typedef RefPtr<const SubstackElement> SubstackPtr;
+typedef RefPtr<const TypeElement> TypePtr;
+typedef RefPtr<const IdentifierElement> IdentifierPtr;
+typedef RefPtr<const DefinedCommandElement> DefinedCommandPtr;
+typedef RefPtr<const PrimitiveCommandElement> PrimitiveCommandPtr;
 
 }  // namespace stackelements
 }  // namespace stacklang
@@ -0,0 +1,57 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the symbol table.
+
+#include "language/stack/symbol.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace stacklang {
+namespace {
+using std::deque;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::string_view;
+using std::unordered_map;
+}  // namespace
+
+Symbol::Symbol(string_view name) {
+  // deque keeps entries in place as it grows, so the index keys stay valid.
+  // Entries never change once added, so the lock is only needed here.
+  static deque<Entry> entries;
+  static unordered_map<string_view, const Entry*> index;
+  static mutex tableLock;
+
+  lock_guard<mutex> guard(tableLock);
+  auto iter = index.find(name);
+  if (iter != index.end()) {
+    entry = iter->second;
+  } else {
+    entries.push_back(Entry{string(name), entries.size()});
+    entry = &entries.back();
+    index.emplace(entry->name, entry);
+  }
+}
+
+const string& Symbol::getName() const noexcept { return entry->name; }
+size_t Symbol::getId() const noexcept { return entry->id; }
+}  // namespace stacklang
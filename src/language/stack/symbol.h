@@ -0,0 +1,70 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Interned identifier names.
+
+#ifndef STACKLANG_LANGUAGE_STACK_SYMBOL_H_
+#define STACKLANG_LANGUAGE_STACK_SYMBOL_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace stacklang {
+// An identifier name, kept once in a table shared by the whole program.
+// Symbols with the same name are the same, so they are compared, hashed and
+// copied without looking at the name.
+class Symbol {
+ public:
+  // The empty symbol, which has no name or id.
+  Symbol() noexcept : entry{nullptr} {}
+  // Gets the symbol for the name, adding it to the table if it is new.
+  explicit Symbol(std::string_view);
+
+  const std::string& getName() const noexcept;
+  // Gives the position of the name in the table. Ids are dense, starting at
+  // zero.
+  size_t getId() const noexcept;
+
+  bool operator==(Symbol other) const noexcept { return entry == other.entry; }
+  bool operator!=(Symbol other) const noexcept { return entry != other.entry; }
+  bool operator<(Symbol other) const noexcept {
+    return getId() < other.getId();
+  }
+
+ private:
+  struct Entry {
+    std::string name;
+    size_t id;
+  };
+
+  const Entry* entry;  // never freed or moved
+};
+}  // namespace stacklang
+
+namespace std {
+template <>
+struct hash<stacklang::Symbol> {
+  size_t operator()(stacklang::Symbol symbol) const noexcept {
+    return symbol.getId();
+  }
+};
+}  // namespace std
+
+#endif  // STACKLANG_LANGUAGE_STACK_SYMBOL_H_
@@ -30,10 +30,12 @@
 
 #include "language/environment.h"
 #include "language/exceptions/languageExceptions.h"
+#include "language/image.h"
 #include "language/language.h"
 #include "language/stack/stack.h"
 #include "language/stack/stackElements.h"
 #include "ui/argReader.h"
+#include "ui/batch.h"
 #include "ui/lineEditor.h"
 #include "ui/ui.h"
 
@@ -41,6 +43,10 @@ namespace {
 using stacklang::EnvTree;
 using stacklang::Stack;
 using stacklang::StackElement;
+using stacklang::encodeImage;
+using stacklang::loadImage;
+using stacklang::numWorkers;
+using stacklang::saveImage;
 using stacklang::stopFlag;
 using stacklang::exceptions::LanguageException;
 using stacklang::stackelements::IdentifierElement;
@@ -51,6 +57,7 @@ using std::endl;
 using std::invalid_argument;
 using std::numeric_limits;
 using std::ofstream;
+using std::out_of_range;
 using std::stoi;
 using std::stoul;
 using std::string;
@@ -66,6 +73,7 @@ using terminalui::HELPMSG;
 using terminalui::init;
 using terminalui::LineEditor;
 using terminalui::printError;
+using terminalui::runBatch;
 using terminalui::uninit;
 
 const char KEY_CTRL = 0x1f;
@@ -75,10 +83,36 @@ const char KEY_CTRL_X = 'x' & KEY_CTRL;
 void outputToFile(ofstream& outputFile, Stack& s) {
   if (outputFile.is_open()) {
     s.reverse();
-    for (auto elm : s) outputFile << static_cast<string>(*elm) << '\n';
+    for (const auto& elm : s) outputFile << static_cast<string>(elm) << '\n';
     outputFile.close();
   }
 }
+
+// Reads the positive whole number given to an option, aborting if it is
+// anything else.
+size_t readCount(char opt, const string& given) noexcept {
+  size_t count = 0;
+  if (!given.empty() && given.find_first_not_of("0123456789") == string::npos) {
+    try {
+      count = stoul(given);
+    } catch (const out_of_range&) {  // reported below
+    }
+  }
+  if (count == 0) {
+    cerr << "(Command line arguments invalid:\nExpected a positive number "
+            "after `-"
+         << opt << "`, but found " << given << ".\nAborting." << endl;
+    exit(EXIT_FAILURE);
+  }
+  return count;
+}
+
+// Prints the number of stack elements allocated over the whole run, and the
+// number still alive.
+void printAllocationStats() {
+  cerr << "Elements allocated: " << StackElement::getAllocationCount()
+       << "\nElements live: " << StackElement::getLiveCount() << endl;
+}
 }  // namespace
 
 int main(int argc, char* argv[]) noexcept {
@@ -96,7 +130,7 @@ int main(int argc, char* argv[]) noexcept {
   // flags parsing
   try {
     args.read(argc, const_cast<const char**>(argv));
-    args.validate("?bh", "dfloI", "I");
+    args.validate("?abh", "dfjloirsI", "Ir");
   } catch (const LanguageException& exn) {
     printError(exn);
     cerr << "\nEncountered error parsing command line arguments. Aborting."
@@ -111,7 +145,15 @@ int main(int argc, char* argv[]) noexcept {
     exit(EXIT_SUCCESS);
   }
 
-  if (!args.hasFlag('b')) {
+  if (args.hasOpt('i')) {  // the image replaces the standard library
+    try {
+      loadImage(args.getOpt('i'), e.getRoot());
+    } catch (const LanguageException& exn) {
+      printError(exn);
+      cerr << "Encountered error loading image. Aborting." << endl;
+      exit(EXIT_FAILURE);
+    }
+  } else if (!args.hasFlag('b')) {
     s.push(new StringElement("std"));
     s.push(new IdentifierElement("include"));
     try {
@@ -138,13 +180,7 @@ int main(int argc, char* argv[]) noexcept {
   }
   if (args.hasOpt('l')) {
     try {
-      s.setLimit(stoul(args.getOpt('l')));
-    } catch (const invalid_argument&) {
-      cerr << "(Command line arguments invalid:\nExpected a number after `-l`, "
-              "but found" +
-                  args.getOpt('l') + ".\nAborting."
-           << endl;
-      exit(EXIT_FAILURE);
+      s.setLimit(readCount('l', args.getOpt('l')));
     } catch (const LanguageException& exn) {
       printError(exn);
       cerr << "Encountered error parsing command line arguments. Aborting."
@@ -152,7 +188,10 @@ int main(int argc, char* argv[]) noexcept {
       exit(EXIT_FAILURE);
     }
   }
-  if (args.hasOpt('o')) {
+  if (args.hasOpt('j')) numWorkers = readCount('j', args.getOpt('j'));
+  // in batch mode, the output option names a directory.
+  bool batchMode = args.hasOpt('r') || args.hasLongOpt('r');
+  if (args.hasOpt('o') && !batchMode) {
     outputFile.open(args.getOpt('o'), ofstream::trunc | ofstream::out);
     if (!outputFile.is_open()) {
       cerr << "Could not open output file.\nAborting." << endl;
@@ -178,6 +217,37 @@ int main(int argc, char* argv[]) noexcept {
     }
   }
 
+  if (args.hasOpt('s')) {  // after all libraries have been included
+    try {
+      saveImage(args.getOpt('s'), e.getRoot());
+    } catch (const LanguageException& exn) {
+      printError(exn);
+      cerr << "Encountered error saving image. Aborting." << endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (batchMode) {  // each script starts from what has been included so far
+    vector<string> paths = args.hasOpt('r') ? vector<string>{args.getOpt('r')}
+                                            : args.getLongOpt('r');
+    size_t failures;
+    try {
+      // loaded once here, rather than by every script that uses them.
+      stopFlag = false;
+      e.getRoot()->autoloadAll();
+      failures = runBatch(paths, encodeImage(e.getRoot()),
+                          args.hasOpt('o') ? args.getOpt('o') : "",
+                          s.getLimit(), numWorkers, cout);
+    } catch (const LanguageException& exn) {
+      printError(exn);
+      cerr << "Encountered error preparing batch. Aborting." << endl;
+      exit(EXIT_FAILURE);
+    }
+    if (args.hasFlag('a')) printAllocationStats();
+
+    exit(failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
   if (args.hasOpt('f')) {  // out of order - must be after other includes have
                            // been processed.
     s.push(new StringElement(args.getOpt('f')));
@@ -193,6 +263,7 @@ int main(int argc, char* argv[]) noexcept {
     }
 
     if (outputFile.is_open()) outputToFile(outputFile, s);
+    if (args.hasFlag('a')) printAllocationStats();
 
     exit(EXIT_SUCCESS);
   }
@@ -215,7 +286,7 @@ int main(int argc, char* argv[]) noexcept {
       break;
     } else if (key == KEY_CTRL_X) {
       if (!s.isEmpty()) {
-        delete s.pop();
+        s.drop();
         drawStack(s);
         drawPrompt(buffer);
       }
@@ -304,6 +375,7 @@ int main(int argc, char* argv[]) noexcept {
   uninit();
 
   outputToFile(outputFile, s);
+  if (args.hasFlag('a')) printAllocationStats();
 
   exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,171 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the batch runner.
+
+#include "ui/batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include "language/exceptions/languageExceptions.h"
+#include "language/interpreter.h"
+#include "ui/ui.h"
+#include "util/workPool.h"
+
+namespace terminalui {
+namespace {
+using stacklang::Interpreter;
+using stacklang::Stack;
+using stacklang::exceptions::LanguageException;
+using stacklang::exceptions::RuntimeError;
+using std::error_code;
+using std::exception;
+using std::map;
+using std::milli;
+using std::ofstream;
+using std::ostream;
+using std::sort;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+using std::filesystem::create_directories;
+using std::filesystem::directory_iterator;
+using std::filesystem::is_directory;
+using std::filesystem::path;
+using std::filesystem::remove;
+using util::WorkPool;
+
+struct Result {
+  bool failed;
+  double milliseconds;
+};
+
+// Adds the scripts a path names - the file itself, or the .sta files in the
+// directory, by name.
+void addScripts(const string& name, vector<string>& scripts) {
+  error_code err;
+  if (!is_directory(name, err)) {
+    scripts.push_back(name);
+    return;
+  }
+
+  vector<string> found;
+  for (const auto& entry : directory_iterator(name, err)) {
+    if (entry.is_regular_file(err) && entry.path().extension() == ".sta") {
+      found.push_back(entry.path().string());
+    }
+  }
+  sort(found.begin(), found.end());
+  scripts.insert(scripts.end(), found.begin(), found.end());
+}
+
+// Gets the file a script's output goes to.
+string outputFile(const string& script, const string& outputDir,
+                  const char* extension) {
+  path file(script);
+  file.replace_extension(extension);
+  if (!outputDir.empty()) file = path(outputDir) / file.filename();
+  return file.string();
+}
+
+// Runs a script, writing its output or error. Never throws.
+bool runScript(const string& script, const string& image,
+               const string& outputDir, size_t limit) noexcept {
+  string errorFile = outputFile(script, outputDir, ".err");
+  try {
+    Interpreter interpreter(image);
+    Stack& s = interpreter.getStack();
+    s.setLimit(limit);
+    interpreter.runFile(script);
+
+    string file = outputFile(script, outputDir, ".out");
+    ofstream fout(file, ofstream::trunc);
+    for (size_t i = s.size(); i-- > 0;) {  // active end last
+      fout << static_cast<string>(s[i]) << '\n';
+    }
+    if (!fout) throw RuntimeError("Could not write output file " + file + ".");
+
+    error_code err;
+    remove(errorFile, err);  // from an earlier run
+    return true;
+  } catch (const LanguageException& exn) {
+    ofstream ferr(errorFile, ofstream::trunc);
+    printError(exn, ferr);
+  } catch (const exception& exn) {
+    ofstream ferr(errorFile, ofstream::trunc);
+    ferr << exn.what() << '\n';
+  }
+
+  error_code err;
+  remove(outputFile(script, outputDir, ".out"), err);  // from an earlier run
+  return false;
+}
+}  // namespace
+
+size_t runBatch(const vector<string>& paths, const string& image,
+                const string& outputDir, size_t limit, size_t numThreads,
+                ostream& report) {
+  vector<string> scripts;
+  for (const string& name : paths) addScripts(name, scripts);
+
+  // scripts writing the same files would overwrite each other's output.
+  map<string, const string*> outputs;
+  for (const string& script : scripts) {
+    path file = path(outputFile(script, outputDir, "")).lexically_normal();
+    auto [iter, added] = outputs.emplace(file.string(), &script);
+    if (!added) {
+      throw RuntimeError("Scripts " + *iter->second + " and " + script +
+                         " would both write " + file.string() + ".out.");
+    }
+  }
+
+  error_code err;
+  if (!outputDir.empty()) create_directories(outputDir, err);
+
+  auto start = steady_clock::now();
+  vector<Result> results(scripts.size());
+  WorkPool pool(numThreads);
+  pool.run(scripts.size(), [&](size_t, size_t i) {
+    auto scriptStart = steady_clock::now();
+    results[i].failed = !runScript(scripts[i], image, outputDir, limit);
+    results[i].milliseconds =
+        duration<double, milli>(steady_clock::now() - scriptStart)
+            .count();
+  });
+  double total =
+      duration<double, milli>(steady_clock::now() - start).count();
+
+  size_t failures = 0;
+  for (size_t i = 0; i < scripts.size(); i++) {
+    report << scripts[i]
+           << (results[i].failed ? ": failed in " : ": ran in ")
+           << results[i].milliseconds << " ms\n";
+    if (results[i].failed) failures++;
+  }
+  report << "Ran " << scripts.size() << " scripts in " << total << " ms on "
+         << pool.size() << " threads, " << failures << " failed." << '\n';
+  report.flush();
+  return failures;
+}
+}  // namespace terminalui
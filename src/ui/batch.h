@@ -0,0 +1,42 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Headless runner for many scripts at once.
+
+#ifndef STACKLANG_UI_BATCH_H_
+#define STACKLANG_UI_BATCH_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace terminalui {
+// Runs each script - each file named, and each .sta file in each directory
+// named - in a fresh interpreter started from the image, on the given number
+// of threads. What a script leaves on the stack is written to a .out file in
+// the format of `-o`, and any error to a .err file, in the output directory
+// or else next to the script. Reports how long each script took, in order.
+// Gives the number of scripts that failed. Throws RuntimeError if two
+// scripts would write to the same files.
+size_t runBatch(const std::vector<std::string>& paths,
+                const std::string& image, const std::string& outputDir,
+                size_t limit, size_t numThreads, std::ostream& report);
+}  // namespace terminalui
+
+#endif  // STACKLANG_UI_BATCH_H_
@@ -36,6 +36,7 @@ using stacklang::exceptions::LanguageException;
 using stacklang::stackelements::CommandElement;
 using std::cerr;
 using std::endl;
+using std::ostream;
 using std::string;
 using std::vector;
 using util::spaces;
@@ -99,7 +100,7 @@ void drawStack(const Stack& s) noexcept {
   auto it = s.begin();
   for (; i > 0 && it != s.end(); i--, ++it) {
     move(i, 0);
-    addString(static_cast<string>(**it));
+    addString(static_cast<string>(*it));
   }
 
   if (long(s.size()) >= maxY - 2) {
@@ -268,20 +269,22 @@ void displayInfo() noexcept {
   while (ERR == getch()) continue;
 }
 
-void printError(const LanguageException& e) noexcept {
-  cerr << e.getKind() << '\n';
-  cerr << e.getMessage() << '\n';
+void printError(const LanguageException& e) noexcept { printError(e, cerr); }
+
+void printError(const LanguageException& e, ostream& out) noexcept {
+  out << e.getKind() << '\n';
+  out << e.getMessage() << '\n';
   if (e.hasContext()) {
-    cerr << e.getContext() << '\n';
-    cerr << spaces(e.getLocation()) << "^" << '\n';
+    out << e.getContext() << '\n';
+    out << spaces(e.getLocation()) << "^" << '\n';
   }
   const vector<string>& stacktrace = e.getTrace();
   if (!stacktrace.empty()) {
-    cerr << '\n';
+    out << '\n';
     for (const string& ctx : stacktrace) {
-      cerr << "From " << ctx << '\n';
+      out << "From " << ctx << '\n';
     }
   }
-  cerr.flush();
+  out.flush();
 }
 }  // namespace terminalui
\ No newline at end of file
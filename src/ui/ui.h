@@ -22,6 +22,7 @@
 #ifndef STACKLANG_UI_UI_H_
 #define STACKLANG_UI_UI_H_
 
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -48,8 +49,10 @@ void addBlock(const std::string& s) noexcept;
 // displays info splash, then waits for a key
 void displayInfo() noexcept;
 
-// prints an error mesage to stderr
+// prints an error mesage to stderr, or to the given stream
 void printError(const stacklang::exceptions::LanguageException&) noexcept;
+void printError(const stacklang::exceptions::LanguageException&,
+                std::ostream&) noexcept;
 
 const int CURSOR_INVISIBLE = 0;
 const int CURSOR_VISIBLE = 1;
@@ -69,11 +72,18 @@ Press any key to continue...)";
 
 const char* const HELPMSG = R"(Usage: stacklang [OPTIONS]
 * `-?`, `-h`: prints this message.
+* `-a`: prints stack element allocation counts on exit.
 * `-b`: runs StackLang without including standard library.
 * `-d N`: sets debugger to mode N.
 * `-f`: runs StackLang interpreter on a file, then stops.
+* `-i image`: starts from an image instead of the standard library.
+* `-j N`: runs parallel primitives on N threads.
 * `-l N`: limits stack to N elements in size.
-* `-o file`: outputs formatted stack to file.
+* `-o file`: outputs formatted stack to file, or to files in this directory
+  with `-r`.
+* `-r path ...`: runs each file, and each .sta file in each directory, on
+  `-j` threads, then stops.
+* `-s image`: saves an image of all definitions after including libraries.
 * `-I filepath ...`: includes files at filepath.
 )";
 }  // namespace terminalui
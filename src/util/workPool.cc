@@ -0,0 +1,136 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// Implementation of the work pool.
+
+#include "util/workPool.h"
+
+#include <algorithm>
+
+namespace util {
+namespace {
+using std::function;
+using std::lock_guard;
+using std::make_unique;
+using std::max;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+thread_local bool inPool = false;
+}  // namespace
+
+WorkPool::WorkPool(size_t numWorkers)
+    : job{nullptr}, batch{0}, remaining{0}, stopping{false} {
+  numWorkers = max(numWorkers, size_t{1});
+  for (size_t i = 0; i < numWorkers; i++) {
+    queues.push_back(make_unique<Queue>());
+  }
+  for (size_t i = 1; i < numWorkers; i++) {
+    threads.emplace_back(&WorkPool::loop, this, i);
+  }
+}
+
+WorkPool::~WorkPool() noexcept {
+  {
+    lock_guard<mutex> guard(lock);
+    stopping = true;
+  }
+  started.notify_all();
+  for (thread& t : threads) t.join();
+}
+
+size_t WorkPool::size() const noexcept { return queues.size(); }
+
+void WorkPool::run(size_t count, const function<void(size_t, size_t)>& task) {
+  if (count == 0) return;
+  lock_guard<mutex> guard(running);
+
+  {
+    lock_guard<mutex> jobGuard(lock);
+    job = &task;
+    remaining = count;
+    batch++;
+  }
+  // shares are contiguous, so neighbouring tasks tend to run in order.
+  for (size_t i = 0; i < queues.size(); i++) {
+    lock_guard<mutex> queueGuard(queues[i]->lock);
+    for (size_t t = count * i / queues.size();
+         t < count * (i + 1) / queues.size(); t++) {
+      queues[i]->tasks.push_back(t);
+    }
+  }
+  started.notify_all();
+
+  inPool = true;
+  work(0);
+  inPool = false;
+
+  unique_lock<mutex> doneLock(lock);
+  finished.wait(doneLock, [this] { return remaining == 0; });
+  job = nullptr;
+}
+
+bool WorkPool::isWorker() noexcept { return inPool; }
+
+void WorkPool::work(size_t worker) {
+  size_t task;
+  while (take(worker, task)) {
+    (*job)(worker, task);
+    lock_guard<mutex> guard(lock);
+    if (--remaining == 0) finished.notify_all();
+  }
+}
+
+bool WorkPool::take(size_t worker, size_t& task) {
+  {
+    Queue& own = *queues[worker];
+    lock_guard<mutex> guard(own.lock);
+    if (!own.tasks.empty()) {
+      task = own.tasks.front();
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  // steals from the far end of the others' shares.
+  for (size_t i = 1; i < queues.size(); i++) {
+    Queue& other = *queues[(worker + i) % queues.size()];
+    lock_guard<mutex> guard(other.lock);
+    if (!other.tasks.empty()) {
+      task = other.tasks.back();
+      other.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkPool::loop(size_t worker) {
+  inPool = true;
+  size_t seen = 0;
+  while (true) {
+    {
+      unique_lock<mutex> guard(lock);
+      started.wait(guard, [this, seen] { return stopping || batch != seen; });
+      if (stopping) return;
+      seen = batch;
+    }
+    work(worker);
+  }
+}
+}  // namespace util
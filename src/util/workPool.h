@@ -0,0 +1,82 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// A pool of threads sharing out numbered tasks.
+
+#ifndef STACKLANG_UTILS_WORKPOOL_H_
+#define STACKLANG_UTILS_WORKPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+// Runs batches of tasks on a fixed set of workers. The thread calling run is
+// worker 0, and the rest are threads kept for the life of the pool. Each
+// worker starts with an even share of the tasks, and takes tasks from the
+// others once its own are done. Only one batch runs at a time.
+class WorkPool {
+ public:
+  explicit WorkPool(size_t numWorkers);
+  WorkPool(const WorkPool&) = delete;
+
+  ~WorkPool() noexcept;
+
+  WorkPool& operator=(const WorkPool&) = delete;
+
+  size_t size() const noexcept;
+
+  // Calls the function with each worker's number and task number, for tasks
+  // 0 to count - 1, and waits for all of them. The function must not throw.
+  void run(size_t count, const std::function<void(size_t, size_t)>& task);
+
+  // Checks if this thread is running a task of a pool. Tasks cannot run
+  // batches of their own.
+  static bool isWorker() noexcept;
+
+ private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+  };
+
+  // Runs tasks until there are none left to take.
+  void work(size_t worker);
+  bool take(size_t worker, size_t& task);
+  void loop(size_t worker);
+
+  std::vector<std::unique_ptr<Queue>> queues;  // one for each worker
+  std::vector<std::thread> threads;
+  const std::function<void(size_t, size_t)>* job;
+
+  std::mutex running;  // held by run, for the whole batch
+  std::mutex lock;     // guards the rest
+  std::condition_variable started;
+  std::condition_variable finished;
+  size_t batch;      // counts batches, so workers can tell a new one started
+  size_t remaining;  // tasks of the batch not yet done
+  bool stopping;
+};
+}  // namespace util
+
+#endif  // STACKLANG_UTILS_WORKPOOL_H_
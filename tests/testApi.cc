@@ -0,0 +1,94 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for the C interface
+
+#include "api/stacklang.h"
+
+#include <string>
+
+#include "catch.hpp"
+
+namespace {
+using std::string;
+}  // namespace
+
+TEST_CASE("values are pushed and read back", "[api]") {
+  stacklang_context* context = stacklang_create();
+  REQUIRE(stacklang_push_number(context, 3) == STACKLANG_OK);
+  REQUIRE(stacklang_push_string(context, "say \"hi\"") == STACKLANG_OK);
+  REQUIRE(stacklang_push(context, "<< 1, `a >>") == STACKLANG_OK);
+  REQUIRE(stacklang_size(context) == 3);
+  REQUIRE(string(stacklang_peek(context, 0)) == "<< 1, `a >>");
+  REQUIRE(string(stacklang_peek(context, 1)) == R"("say \"hi\"")");
+  REQUIRE(string(stacklang_peek(context, 2)) == "3");
+  REQUIRE(stacklang_peek(context, 3) == nullptr);
+  REQUIRE(stacklang_pop(context) == STACKLANG_OK);
+  REQUIRE(stacklang_size(context) == 2);
+  stacklang_clear(context);
+  REQUIRE(stacklang_pop(context) == STACKLANG_ERROR);
+  stacklang_destroy(context);
+}
+
+TEST_CASE("text is evaluated", "[api]") {
+  stacklang_context* context = stacklang_create();
+  REQUIRE(stacklang_include(context, "std") == STACKLANG_OK);
+  REQUIRE(stacklang_eval(context, "1\n2\nadd\nincrement") == STACKLANG_OK);
+  REQUIRE(stacklang_error(context) == nullptr);
+  REQUIRE(string(stacklang_peek(context, 0)) == "4");
+  stacklang_destroy(context);
+}
+
+TEST_CASE("errors are reported", "[api]") {
+  stacklang_context* context = stacklang_create();
+  REQUIRE(stacklang_eval(context, "1\n\"a\"\nadd") == STACKLANG_ERROR);
+  REQUIRE(string(stacklang_error(context)) ==
+          "Type Mismatch:\nExpected Number, given \"a\"\n");
+  REQUIRE(stacklang_push(context, "<< 1") == STACKLANG_ERROR);
+  REQUIRE(stacklang_push_number(context, 1) == STACKLANG_OK);
+  REQUIRE(stacklang_error(context) == nullptr);
+  stacklang_destroy(context);
+}
+
+TEST_CASE("numbers are pushed as they would be written", "[api]") {
+  stacklang_context* context = stacklang_create();
+  REQUIRE(stacklang_push_number(context, 1.5) == STACKLANG_OK);
+  REQUIRE(string(stacklang_peek(context, 0)) == "1.5");
+  REQUIRE(stacklang_push_number(context, -0.1) == STACKLANG_OK);
+  REQUIRE(string(stacklang_peek(context, 0)) == "-0.1");
+  REQUIRE(stacklang_push_number(context, 1e20) == STACKLANG_OK);
+  REQUIRE(string(stacklang_peek(context, 0)) == "100000000000000000000");
+
+  // the same as evaluating the number's text.
+  REQUIRE(stacklang_push_number(context, 0.1) == STACKLANG_OK);
+  REQUIRE(stacklang_eval(context, "0.1\nequal?") == STACKLANG_OK);
+  REQUIRE(string(stacklang_peek(context, 0)) == "true");
+  stacklang_destroy(context);
+}
+
+TEST_CASE("contexts are cloned", "[api]") {
+  stacklang_context* original = stacklang_create();
+  REQUIRE(stacklang_eval(original, "<<>>\n<<>>\n<< 42 >>\n`answer\ndefine") ==
+          STACKLANG_OK);
+  stacklang_context* copy = stacklang_clone(original);
+  REQUIRE(copy != nullptr);
+  stacklang_destroy(original);
+  REQUIRE(stacklang_eval(copy, "answer") == STACKLANG_OK);
+  REQUIRE(string(stacklang_peek(copy, 0)) == "42");
+  stacklang_destroy(copy);
+}
@@ -0,0 +1,158 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for the batch runner
+
+#include "ui/batch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "catch.hpp"
+#include "language/exceptions/languageExceptions.h"
+#include "language/interpreter.h"
+
+namespace {
+using stacklang::Interpreter;
+using stacklang::exceptions::RuntimeError;
+using std::ifstream;
+using std::numeric_limits;
+using std::ofstream;
+using std::ostringstream;
+using std::string;
+using std::filesystem::create_directories;
+using std::filesystem::directory_iterator;
+using std::filesystem::exists;
+using std::filesystem::path;
+using std::filesystem::remove_all;
+using std::filesystem::temp_directory_path;
+using terminalui::runBatch;
+
+string contents(const path& file) {
+  ifstream fin(file);
+  ostringstream out;
+  out << fin.rdbuf();
+  return out.str();
+}
+}  // namespace
+
+TEST_CASE("batches run each script in its own interpreter", "[batch]") {
+  path dir = temp_directory_path() / "stacklangBatchTest";
+  remove_all(dir);
+  create_directories(dir / "scripts");
+  ofstream(dir / "scripts" / "good.sta") << "1\n2\nadd\n\"done\"\n";
+  ofstream(dir / "scripts" / "bad.sta") << "1\n\"a\"\nadd\n";
+  ofstream(dir / "scripts" / "define.sta")
+      << "<<>>\n<<>>\n<< 1 >>\n`other\ndefine\n";
+  ofstream(dir / "scripts" / "notes.txt") << "not a script\n";
+
+  Interpreter base;
+  base.eval("<<>>\n<<>>\n<< 7 >>\n`shared\ndefine");
+  string image = base.makeImage();
+  ostringstream report;
+
+  REQUIRE(runBatch({(dir / "scripts").string()}, image,
+                   (dir / "out").string(), 100, 3, report) == 1);
+  REQUIRE(contents(dir / "out" / "good.out") == "3\n\"done\"\n");
+  REQUIRE(contents(dir / "out" / "bad.err") ==
+          "Type Mismatch:\nExpected Number, given \"a\"\n");
+  REQUIRE_FALSE(exists(dir / "out" / "bad.out"));
+  REQUIRE_FALSE(exists(dir / "out" / "notes.out"));
+  REQUIRE(report.str().find("Ran 3 scripts") != string::npos);
+
+  // each script starts from the image, whatever the others defined.
+  ofstream(dir / "scripts" / "bad.sta") << "shared\n`other\nbound?\n";
+  REQUIRE(runBatch({(dir / "scripts").string()}, image,
+                   (dir / "out").string(), 100, 3, report) == 0);
+  REQUIRE(contents(dir / "out" / "bad.out") == "7\nfalse\n");
+  REQUIRE_FALSE(exists(dir / "out" / "bad.err"));
+
+  // a script that fails no longer leaves its old output.
+  ofstream(dir / "scripts" / "bad.sta") << "1\n\"a\"\nadd\n";
+  REQUIRE(runBatch({(dir / "scripts").string()}, image,
+                   (dir / "out").string(), 100, 3, report) == 1);
+  REQUIRE_FALSE(exists(dir / "out" / "bad.out"));
+  REQUIRE(exists(dir / "out" / "bad.err"));
+
+  // scripts are not cached as included files are.
+  REQUIRE_FALSE(exists(dir / "scripts" / "good.stc"));
+
+  remove_all(dir);
+}
+
+TEST_CASE("batches reject scripts with the same output", "[batch]") {
+  path dir = temp_directory_path() / "stacklangBatchSameName";
+  remove_all(dir);
+  create_directories(dir / "a");
+  create_directories(dir / "b");
+  ofstream(dir / "a" / "x.sta") << "1\n";
+  ofstream(dir / "b" / "x.sta") << "2\n";
+  ostringstream report;
+
+  string image = Interpreter().makeImage();
+  REQUIRE_THROWS_AS(runBatch({(dir / "a").string(), (dir / "b").string()},
+                             image, (dir / "out").string(), 100, 2, report),
+                    RuntimeError);
+  REQUIRE_FALSE(exists(dir / "out" / "x.out"));
+
+  // without an output directory, each writes beside itself.
+  REQUIRE(runBatch({(dir / "a").string(), (dir / "b").string()}, image, "",
+                   100, 2, report) == 0);
+  REQUIRE(contents(dir / "a" / "x.out") == "1\n");
+  REQUIRE(contents(dir / "b" / "x.out") == "2\n");
+
+  remove_all(dir);
+}
+
+TEST_CASE("batches match the expected output of each script", "[batch]") {
+  // tests/scripts/expected has what each script leaves, or the error it
+  // stops with, as run with the standard library by -f.
+  path scripts = "tests/scripts";
+  path dir = temp_directory_path() / "stacklangBatchCorpus";
+  remove_all(dir);
+
+  Interpreter base;
+  base.include("std");
+  base.getRoot()->autoloadAll();  // as -r does
+  ostringstream report;
+  size_t failures =
+      runBatch({scripts.string()}, base.makeImage(), dir.string(),
+               numeric_limits<size_t>::max(), 4, report);
+
+  size_t expectedFailures = 0;
+  size_t count = 0;
+  for (const auto& entry : directory_iterator(scripts / "expected")) {
+    path name = entry.path().filename();
+    if (name.extension() == ".err") expectedFailures++;
+    INFO(name.string());
+    REQUIRE(exists(dir / name));
+    REQUIRE(contents(dir / name) == contents(entry.path()));
+    count++;
+  }
+  REQUIRE(count == 47);
+  REQUIRE(failures == expectedFailures);
+  for (const auto& entry : directory_iterator(dir)) {
+    INFO(entry.path().filename().string());
+    REQUIRE(exists(scripts / "expected" / entry.path().filename()));
+  }
+
+  remove_all(dir);
+}
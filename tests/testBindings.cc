@@ -0,0 +1,95 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for binding tables
+
+#include "language/bindings.h"
+
+#include <string>
+
+#include "catch.hpp"
+#include "language/environment.h"
+
+namespace {
+using stacklang::Bindings;
+using stacklang::EnvTree;
+using stacklang::Symbol;
+using stacklang::Value;
+using std::to_string;
+}  // namespace
+
+TEST_CASE("bindings find inserted names", "[bindings]") {
+  Bindings bindings;
+  Symbol name("bindings-test-name");
+  REQUIRE(bindings.find(name) == nullptr);
+  REQUIRE(bindings.insert(name, Value(1.0L)));
+  REQUIRE_FALSE(bindings.insert(name, Value(2.0L)));
+  REQUIRE(bindings.size() == 1);
+  REQUIRE(bindings.find(name)->getNumber() == 1.0L);
+  bindings.assign(name, Value(2.0L));
+  REQUIRE(bindings.find(name)->getNumber() == 2.0L);
+}
+
+TEST_CASE("bindings keep names after others are erased", "[bindings]") {
+  Bindings bindings;
+  for (int i = 0; i < 100; i++) {
+    bindings.insert(Symbol("bindings-test-" + to_string(i)),
+                    Value(static_cast<long double>(i)));
+  }
+  for (int i = 0; i < 100; i += 3) {
+    REQUIRE(bindings.erase(Symbol("bindings-test-" + to_string(i))));
+  }
+  REQUIRE_FALSE(bindings.erase(Symbol("bindings-test-0")));
+  for (int i = 0; i < 100; i++) {
+    const Value* found = bindings.find(Symbol("bindings-test-" + to_string(i)));
+    if (i % 3 == 0) {
+      REQUIRE(found == nullptr);
+    } else {
+      REQUIRE(found != nullptr);
+      REQUIRE(found->getNumber() == i);
+    }
+  }
+  REQUIRE(bindings.size() == 66);
+}
+
+TEST_CASE("bindings visit each binding once", "[bindings]") {
+  Bindings bindings;
+  for (int i = 0; i < 20; i++) {
+    bindings.insert(Symbol("bindings-visit-" + to_string(i)), Value(true));
+  }
+  size_t count = 0;
+  for (const auto& binding : bindings) {
+    REQUIRE(binding.first.getName().substr(0, 15) == "bindings-visit-");
+    count++;
+  }
+  REQUIRE(count == 20);
+}
+
+TEST_CASE("environment versions are not shared between trees", "[bindings]") {
+  EnvTree first;
+  EnvTree second;
+  REQUIRE(first.getRoot()->getVersion() != second.getRoot()->getVersion());
+
+  // a cached lookup from one tree must not look current in the other.
+  Symbol name("bindings-version");
+  first.getRoot()->bindings.insert(name, Value(true));
+  first.getRoot()->bindingChanged(name);
+  second.getRoot()->bindings.insert(name, Value(false));
+  second.getRoot()->bindingChanged(name);
+  REQUIRE(first.getRoot()->getVersion() != second.getRoot()->getVersion());
+}
@@ -0,0 +1,176 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for running defined commands: compiled bodies, name lookup, tail
+// calls, and the frames of calls
+
+#include <atomic>
+#include <initializer_list>
+#include <string>
+
+#include "catch.hpp"
+#include "language/environment.h"
+#include "language/exceptions/languageExceptions.h"
+#include "language/interpreter.h"
+#include "language/language.h"
+#include "language/slotArena.h"
+#include "language/stack/stack.h"
+
+namespace {
+using stacklang::EnvTree;
+using stacklang::execute;
+using stacklang::ExecutionScope;
+using stacklang::Interpreter;
+using stacklang::SlotArena;
+using stacklang::Stack;
+using stacklang::StackElement;
+using stacklang::Value;
+using stacklang::exceptions::RuntimeError;
+using std::atomic_bool;
+using std::initializer_list;
+using std::string;
+
+string top(Interpreter& interpreter) {
+  return static_cast<string>(interpreter.getStack().top());
+}
+
+// Runs each element of the program in the environment.
+void runIn(Stack& s, EnvTree& env, initializer_list<string> program) {
+  for (const string& text : program) {
+    s.push(Value(StackElement::parse(text)));
+    execute(s, env.getRoot());
+  }
+}
+}  // namespace
+
+TEST_CASE("compiled bodies see globals change after they are defined",
+          "[execute]") {
+  Interpreter interpreter;
+  // read is compiled before x exists.
+  interpreter.eval("<< >>\n<< >>\n<< x >>\n`read\ndefine");
+  REQUIRE_THROWS_AS(interpreter.eval("read"), RuntimeError);
+  interpreter.getStack().clear();
+
+  interpreter.eval("<< >>\n<< >>\n<< 1 >>\n`x\ndefine\nread");
+  REQUIRE(top(interpreter) == "1");
+
+  // the binding found is forgotten once it is undefined.
+  interpreter.eval("`x\nundefine");
+  REQUIRE_THROWS_AS(interpreter.eval("read"), RuntimeError);
+  interpreter.getStack().clear();
+  interpreter.eval("<< >>\n<< >>\n<< 2 >>\n`x\ndefine\nread");
+  REQUIRE(top(interpreter) == "2");
+
+  // as it is when another is exported in its place.
+  interpreter.eval(R"(`x
+undefine
+<< >>
+<< >>
+<< <<>>, <<>>, << 3 >>, `x, define, `x, export >>
+`make-x
+define
+make-x
+read)");
+  REQUIRE(top(interpreter) == "3");
+}
+
+TEST_CASE("tail calls run in constant memory", "[execute]") {
+  EnvTree env;
+  Stack s;
+  SlotArena arena;
+  atomic_bool stop(false);
+  ExecutionScope scope(stop, &arena);
+
+  // far deeper than the native stack would allow, were calls nested, and
+  // the slots of each call are given back before the next is made.
+  runIn(s, env,
+        {"<< Number, Number >>", "<< `count, `n >>",
+         "<< n, count, `loop-done, `loop-again, n, 0, equal?, if, unquote >>",
+         "`loop", "define", "<< Number, Number >>", "<< `count, `n >>",
+         "<< count >>", "`loop-done", "define", "<< Number, Number >>",
+         "<< `count, `n >>", "<< n, 1, subtract, count, 1, add, loop >>",
+         "`loop-again", "define", "200000", "0", "loop"});
+  REQUIRE(static_cast<string>(s.top()) == "200000");
+  REQUIRE(arena.capacity() == 1024);
+
+  // unlike calls that are not in tail position.
+  runIn(s, env,
+        {"<< Number >>", "<< `n >>",
+         "<< n, `nest-done, `nest-more, n, 0, equal?, if, unquote >>",
+         "`nest", "define", "<< Number >>", "<< `n >>", "<< 0 >>",
+         "`nest-done", "define", "<< Number >>", "<< `n >>",
+         "<< n, 1, subtract, nest, 1, add >>", "`nest-more", "define", "5000",
+         "nest"});
+  REQUIRE(static_cast<string>(s.top()) == "5000");
+  REQUIRE(arena.capacity() > 1024);
+}
+
+TEST_CASE("nested commands read the parameters of enclosing calls",
+          "[execute]") {
+  Interpreter interpreter;
+  interpreter.eval(R"(<< Number >>
+<< `a >>
+<<
+  << Number >>
+  << `b >>
+  <<
+    << Number >>
+    << `c >>
+    << a, b, c, add, add >>
+    `inner
+    define
+    100, inner
+  >>
+  `middle
+  define
+  10, middle
+>>
+`outer
+define
+1
+outer
+2
+outer)");
+  REQUIRE(top(interpreter) == "112");
+  interpreter.getStack().drop();
+  REQUIRE(top(interpreter) == "111");
+}
+
+TEST_CASE("recursive calls keep their own parameters and definitions",
+          "[execute]") {
+  // each call defines get, reading its own n, and runs it after the call it
+  // makes returns.
+  Interpreter interpreter;
+  interpreter.eval(R"(<< Number >>
+<< `n >>
+<< <<>>, <<>>, << n >>, `get, define,
+   <<>>, <<>>, << n, 1, subtract, sum >>, `sum-more, define,
+   <<>>, <<>>, << 0 >>, `sum-done, define,
+   `sum-more, `sum-done, n, 0, greater-than?, if, unquote, get, add >>
+`sum
+define
+3
+sum
+2000
+sum)");
+  REQUIRE(top(interpreter) == "2001000");
+  interpreter.getStack().drop();
+  REQUIRE(top(interpreter) == "6");
+  interpreter.eval("`get\nbound?");
+  REQUIRE(top(interpreter) == "false");
+}
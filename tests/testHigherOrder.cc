@@ -0,0 +1,173 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for the higher-order substack primitives, against the reference
+// versions in libs/substack-reference.sta
+
+#include <initializer_list>
+#include <string>
+
+#include "catch.hpp"
+#include "language/environment.h"
+#include "language/exceptions/languageExceptions.h"
+#include "language/language.h"
+#include "language/stack/stack.h"
+#include "language/stack/stackElements.h"
+
+namespace {
+using stacklang::EnvTree;
+using stacklang::execute;
+using stacklang::numWorkers;
+using stacklang::Stack;
+using stacklang::StackElement;
+using stacklang::Value;
+using stacklang::exceptions::RuntimeError;
+using stacklang::exceptions::TypeError;
+using stacklang::stackelements::IdentifierElement;
+using stacklang::stackelements::StringElement;
+using stacklang::stackelements::SubstackElement;
+using std::initializer_list;
+using std::string;
+
+// Runs the program with the standard and reference libraries included,
+// giving the top of the stack.
+string run(initializer_list<string> program) {
+  EnvTree env;
+  Stack s;
+  for (const char* library : {"std", "substack-reference"}) {
+    s.push(new StringElement(library));
+    s.push(new IdentifierElement("include"));
+    execute(s, env.getRoot());
+  }
+  for (const string& text : program) {
+    s.push(Value(StackElement::parse(text)));
+    execute(s, env.getRoot());
+  }
+  return static_cast<string>(s.top());
+}
+
+// Runs each element of the program in the environment.
+void runIn(Stack& s, EnvTree& env, initializer_list<string> program) {
+  for (const string& text : program) {
+    s.push(Value(StackElement::parse(text)));
+    execute(s, env.getRoot());
+  }
+}
+
+// Counts the modules the environment has loaded.
+size_t countModules(Stack& s, EnvTree& env) {
+  runIn(s, env, {"loaded-modules"});
+  size_t count =
+      static_cast<const SubstackElement*>(s.top().get())->getData().size();
+  s.drop();
+  return count;
+}
+}  // namespace
+
+TEST_CASE("map matches reference", "[primitives][Substack][map]") {
+  REQUIRE(run({"<< 1, 2, 3, 4 >>", "`increment", "map"}) ==
+          run({"<< 1, 2, 3, 4 >>", "`increment", "map-reference"}));
+  REQUIRE(run({"<< 1, 2, 3, 4 >>", "`increment", "map"}) ==
+          "<< 2, 3, 4, 5 >>");
+  REQUIRE(run({"<<>>", "`increment", "map"}) ==
+          run({"<<>>", "`increment", "map-reference"}));
+}
+
+TEST_CASE("filter matches reference", "[primitives][Substack][filter]") {
+  REQUIRE(run({"<< 1, 2, 3, 4, 5 >>", "`even?", "filter"}) ==
+          run({"<< 1, 2, 3, 4, 5 >>", "`even?", "filter-reference"}));
+  REQUIRE(run({"<< 1, 2, 3, 4, 5 >>", "`even?", "filter"}) == "<< 2, 4 >>");
+}
+
+TEST_CASE("filter survives a predicate pushing onto its input",
+          "[primitives][Substack][filter]") {
+  REQUIRE(run({"<< >>", "<< >>", "<< << 1, 2, 3, 4 >> >>", "`xs", "define",
+               "<< Any >>", "<< `x >>", "<< xs, 9, push, drop, true >>",
+               "`pred", "define", "xs", "`pred", "filter"}) ==
+          "<< 1, 2, 3, 4 >>");
+}
+
+TEST_CASE("folds match reference", "[primitives][Substack][fold]") {
+  REQUIRE(run({R"(<< "a", "b", "c" >>)", R"("|")", "`string-append",
+               "foldl"}) == R"("cba|")");
+  REQUIRE(run({R"(<< "a", "b", "c" >>)", R"("|")", "`string-append",
+               "foldl-reference"}) == R"("cba|")");
+  REQUIRE(run({R"(<< "a", "b", "c" >>)", R"("|")", "`string-append",
+               "foldr"}) == R"("abc|")");
+  REQUIRE(run({R"(<< "a", "b", "c" >>)", R"("|")", "`string-append",
+               "foldr-reference"}) == R"("abc|")");
+}
+
+TEST_CASE("for-each matches reference", "[primitives][Substack][for-each]") {
+  REQUIRE(run({"0", "<< 1, 2, 3 >>", "`add", "for-each"}) ==
+          run({"0", "<< 1, 2, 3 >>", "`add", "for-each-reference"}));
+}
+
+TEST_CASE("parallel-map matches map", "[primitives][Substack][map]") {
+  numWorkers = 4;  // the pool is made on first use
+  REQUIRE(run({"<< 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 >>",
+               "`increment", "parallel-map"}) ==
+          run({"<< 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 >>",
+               "`increment", "map"}));
+  REQUIRE(run({"<<>>", "`increment", "parallel-map"}) == "<< (empty) >>");
+  REQUIRE_THROWS_AS(run({R"(<< 1, "a", 3, true >>)", "`increment",
+                         "parallel-map"}),
+                    TypeError);
+}
+
+TEST_CASE("parallel-map leaves modules unloaded",
+          "[primitives][Substack][map]") {
+  numWorkers = 4;
+  EnvTree env;
+  Stack s;
+  runIn(s, env, {R"("std")", "include"});
+  size_t loaded = countModules(s, env);
+  runIn(s, env, {"<< Number >>", "<< `x >>", "<< x, x, add >>", "`twice",
+                 "define", "<< 1, 2, 3, 4, 5, 6, 7, 8, 9 >>", "`twice",
+                 "parallel-map"});
+  REQUIRE(static_cast<string>(s.top()) ==
+          "<< 2, 4, 6, 8, 10, 12, 14, 16, 18 >>");
+  REQUIRE(countModules(s, env) == loaded);
+}
+
+TEST_CASE("parallel-map sees new definitions",
+          "[primitives][Substack][map]") {
+  numWorkers = 4;
+  EnvTree env;
+  Stack s;
+  runIn(s, env, {R"("std")", "include", "<< Number >>", "<< `x >>",
+                 "<< x, helper >>", "`go", "define"});
+  REQUIRE_THROWS_AS(
+      runIn(s, env, {"<< 1, 2, 3, 4, 5, 6, 7, 8 >>", "`go", "parallel-map"}),
+      RuntimeError);
+  runIn(s, env, {"<< Number >>", "<< `x >>", "<< x, 1, add >>", "`helper",
+                 "define", "<< 1, 2, 3, 4, 5, 6, 7, 8 >>", "`go",
+                 "parallel-map"});
+  REQUIRE(static_cast<string>(s.top()) == "<< 2, 3, 4, 5, 6, 7, 8, 9 >>");
+}
+
+TEST_CASE("parallel-map runs the command on a stack of its own",
+          "[primitives][Substack][map]") {
+  // whatever the number of threads, the command cannot reach the elements
+  // under the substack.
+  REQUIRE_THROWS(run({"5", "<< Number >>", "<< `x >>", "<< x, add >>",
+                      "`add-below", "define", "<< 1 >>", "`add-below",
+                      "parallel-map"}));
+  REQUIRE(run({"5", "<< Number >>", "<< `x >>", "<< x, add >>", "`add-below",
+               "define", "<< 1 >>", "`add-below", "map"}) == "<< 6 >>");
+}
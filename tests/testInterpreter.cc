@@ -0,0 +1,183 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for interpreter contexts, including running them on many threads
+
+#include "language/interpreter.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "language/exceptions/languageExceptions.h"
+#include "language/language.h"
+
+namespace {
+using stacklang::Interpreter;
+using stacklang::stopFlag;
+using stacklang::exceptions::StopError;
+using std::string;
+using std::thread;
+using std::to_string;
+using std::vector;
+using std::chrono::milliseconds;
+using std::this_thread::sleep_for;
+
+// Counts down from n to zero by recursion, leaving the number of calls.
+const char COUNTDOWN[] = R"(<< Number >>
+<< `n >>
+<< n, 1, subtract, countdown, 1, add >>
+`countdown-r
+define
+<< Number >>
+<< `n >>
+<< 0 >>
+`countdown-b
+define
+<< Number >>
+<< `n >>
+<< n, n, 0, greater-than?, `countdown-r, `countdown-b, 3, rotate, if, unquote >>
+`countdown
+define
+)";
+
+string top(Interpreter& interpreter) {
+  return static_cast<string>(interpreter.getStack().top());
+}
+}  // namespace
+
+TEST_CASE("interpreters evaluate text", "[interpreter]") {
+  Interpreter interpreter;
+  interpreter.eval("1\n2\nadd\n<< 3,\n4 >>");
+  REQUIRE(interpreter.getStack().size() == 2);
+  REQUIRE(top(interpreter) == "<< 3, 4 >>");
+  interpreter.getStack().drop();
+  REQUIRE(top(interpreter) == "3");
+}
+
+TEST_CASE("interpreters do not share definitions", "[interpreter]") {
+  Interpreter first;
+  Interpreter second;
+  first.eval("<<>>\n<<>>\n<< 1 >>\n`value\ndefine");
+  second.eval("<<>>\n<<>>\n<< 2 >>\n`value\ndefine");
+  first.eval("value");
+  second.eval("value");
+  REQUIRE(top(first) == "1");
+  REQUIRE(top(second) == "2");
+}
+
+TEST_CASE("interpreters start from images", "[interpreter]") {
+  Interpreter base;
+  base.include("std");
+  base.eval(COUNTDOWN);
+  string image = base.makeImage();
+
+  Interpreter copy(image);
+  copy.eval("10\ncountdown");
+  REQUIRE(top(copy) == "10");
+  REQUIRE(base.getStack().isEmpty());
+}
+
+TEST_CASE("interpreters run on separate threads", "[interpreter]") {
+  Interpreter base;
+  base.include("std");
+  base.eval(COUNTDOWN);
+  string image = base.makeImage();
+
+  const size_t NUM_THREADS = 8;
+  vector<string> results(NUM_THREADS);
+  vector<thread> threads;
+  for (size_t i = 0; i < NUM_THREADS; i++) {
+    threads.emplace_back([&image, &results, i] {
+      Interpreter interpreter(image);
+      // each thread redefines the same name, which must not be seen by the
+      // others.
+      interpreter.eval("<<>>\n<<>>\n<< " + to_string(i) +
+                       " >>\n`offset\ndefine");
+      for (size_t round = 0; round < 20; round++) {
+        interpreter.eval("200\ncountdown\noffset\nadd");
+      }
+      results[i] = top(interpreter);
+    });
+  }
+  for (thread& t : threads) t.join();
+
+  for (size_t i = 0; i < NUM_THREADS; i++) {
+    REQUIRE(results[i] == to_string(200 + i));
+  }
+}
+
+TEST_CASE("interpreters stop separately", "[interpreter]") {
+  Interpreter base;
+  base.eval(COUNTDOWN);
+  string image = base.makeImage();
+
+  Interpreter stopped(image);
+  Interpreter running(image);
+  bool wasStopped = false;
+  thread stopping([&stopped, &wasStopped] {
+    try {
+      stopped.eval("<<>>\n<<>>\n<< forever >>\n`forever\ndefine\nforever");
+    } catch (const StopError&) {
+      wasStopped = true;
+    }
+  });
+  sleep_for(milliseconds(50));
+  stopped.stop();
+  stopping.join();
+
+  REQUIRE(wasStopped);
+  REQUIRE_FALSE(stopFlag);
+  running.eval("100\ncountdown");
+  REQUIRE(top(running) == "100");
+}
+
+TEST_CASE("definitions of a call are seen again when an inner call returns",
+          "[interpreter]") {
+  // The outer call of f shadows x, and exports a command reading x, which
+  // the inner call of f runs without the shadow. Running it again in the
+  // outer call must see the shadow, even though the global x was found and
+  // cached in between.
+  Interpreter interpreter;
+  interpreter.eval(R"(<<>>
+<<>>
+<< 1 >>
+`x
+define
+<< Any, Any, Any, Any >>
+<< `a, `b, `c, `d >>
+<< >>
+`discard
+define
+<< Boolean >>
+<< `outer? >>
+<< <<>>, <<>>, << 2 >>, `x, `define, `discard, outer?, if, unquote,
+   <<>>, <<>>, << x >>, `read, `define, `discard, outer?, if, unquote,
+   `read, `export, `drop, outer?, if, unquote,
+   <<>>, <<>>, << false, f, read >>, `run-outer, define,
+   `run-outer, `read, outer?, if, unquote >>
+`f
+define
+true
+f)");
+  REQUIRE(top(interpreter) == "2");
+  interpreter.getStack().drop();
+  REQUIRE(top(interpreter) == "1");
+}
@@ -0,0 +1,232 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for modules: the parse cache, including once, autoloading, and images
+// saved to files
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "language/exceptions/languageExceptions.h"
+#include "language/image.h"
+#include "language/interpreter.h"
+#include "language/sourceCache.h"
+#include "language/stack/stackElements.h"
+
+namespace {
+using stacklang::cachePath;
+using stacklang::Interpreter;
+using stacklang::loadImage;
+using stacklang::readCache;
+using stacklang::saveImage;
+using stacklang::Stack;
+using stacklang::StackElement;
+using stacklang::Value;
+using stacklang::writeCache;
+using stacklang::exceptions::RuntimeError;
+using stacklang::exceptions::TypeError;
+using stacklang::stackelements::StringElement;
+using stacklang::stackelements::SubstackElement;
+using std::ofstream;
+using std::string;
+using std::vector;
+using std::filesystem::create_directories;
+using std::filesystem::exists;
+using std::filesystem::path;
+using std::filesystem::remove_all;
+using std::filesystem::temp_directory_path;
+
+// Defines triple, and leaves a marker each time it is run.
+const char TRIPLE[] = R"("ran"
+<< Number >>
+<< `x >>
+<< x, x, x, add, add >>
+`triple
+define
+)";
+
+// Makes an empty directory for a test.
+path makeDir(const string& name) {
+  path dir = temp_directory_path() / name;
+  remove_all(dir);
+  create_directories(dir);
+  return dir;
+}
+
+string top(Interpreter& interpreter) {
+  return static_cast<string>(interpreter.getStack().top());
+}
+
+// Gives what loaded-modules reports, as << path, seconds >> for each module.
+Stack loadedModules(Interpreter& interpreter) {
+  interpreter.eval("loaded-modules");
+  Stack modules = static_cast<const SubstackElement*>(
+                      interpreter.getStack().top().get())
+                      ->getData();
+  interpreter.getStack().drop();
+  return modules;
+}
+}  // namespace
+
+TEST_CASE("included files are cached, and the cache is checked",
+          "[modules]") {
+  path dir = makeDir("stacklangParseCache");
+  path source = dir / "answer.sta";
+  ofstream(source) << "41\n";
+
+  Interpreter first;
+  first.include(source.string());
+  REQUIRE(top(first) == "41");
+  REQUIRE(cachePath(source.string()) == (dir / "answer.stc").string());
+  REQUIRE(exists(dir / "answer.stc"));
+  vector<Value> elements;
+  REQUIRE(readCache(source.string(), elements));
+  REQUIRE(elements.size() == 1);
+
+  // a cache matching the source is used instead of it.
+  writeCache(source.string(), {Value(StackElement::parse("42"))});
+  Interpreter second;
+  second.include(source.string());
+  REQUIRE(top(second) == "42");
+
+  // once the source changes, the cache is ignored and made again.
+  ofstream(source) << "43\n\n";
+  REQUIRE_FALSE(readCache(source.string(), elements));
+  Interpreter third;
+  third.include(source.string());
+  REQUIRE(top(third) == "43");
+  REQUIRE(readCache(source.string(), elements));
+
+  // only .sta files are cached.
+  REQUIRE(cachePath((dir / "notes.txt").string()).empty());
+
+  remove_all(dir);
+}
+
+TEST_CASE("modules are only included once", "[modules]") {
+  path dir = makeDir("stacklangIncludeOnce");
+  ofstream(dir / "triple.sta") << TRIPLE;
+
+  Interpreter interpreter;
+  interpreter.include((dir / "triple.sta").string());
+  // named another way, it is still the same module.
+  interpreter.include((dir / "triple").string());
+  interpreter.include((dir / "." / "triple.sta").string());
+  REQUIRE(interpreter.getStack().size() == 1);
+  REQUIRE(top(interpreter) == "\"ran\"");
+  interpreter.eval("2\ntriple");
+  REQUIRE(top(interpreter) == "6");
+
+  // a module that failed may be included again once fixed.
+  ofstream(dir / "broken.sta") << "1\n\"a\"\nadd\n";
+  REQUIRE_THROWS_AS(interpreter.include((dir / "broken.sta").string()),
+                    TypeError);
+  ofstream(dir / "broken.sta") << "\"fixed\"\n";
+  interpreter.include((dir / "broken.sta").string());
+  REQUIRE(top(interpreter) == "\"fixed\"");
+
+  remove_all(dir);
+}
+
+TEST_CASE("loaded-modules gives the time each module took", "[modules]") {
+  path dir = makeDir("stacklangLoadedModules");
+  ofstream(dir / "triple.sta") << TRIPLE;
+
+  Interpreter interpreter;
+  REQUIRE(loadedModules(interpreter).isEmpty());
+  interpreter.include((dir / "triple.sta").string());
+  Stack modules = loadedModules(interpreter);
+  REQUIRE(modules.size() == 1);
+
+  const Stack& module =
+      static_cast<const SubstackElement*>(modules.top().get())->getData();
+  REQUIRE(module.size() == 2);
+  REQUIRE(static_cast<const StringElement*>(module[0].get())->getData() ==
+          (dir / "triple.sta").string());
+  REQUIRE(module[1].getType() == StackElement::DataType::Number);
+  REQUIRE(module[1].getNumber() > 0);
+
+  remove_all(dir);
+}
+
+TEST_CASE("autoloaded modules load when a name they define is first used",
+          "[modules]") {
+  path dir = makeDir("stacklangAutoload");
+  ofstream(dir / "triple.sta") << TRIPLE;
+  string autoload = "\"" + (dir / "triple.sta").string() + "\"\nautoload";
+
+  Interpreter used;
+  used.eval(autoload);
+  REQUIRE(used.getStack().isEmpty());
+  REQUIRE(loadedModules(used).isEmpty());
+  used.eval("2\ntriple");
+  REQUIRE(top(used) == "6");
+  REQUIRE(loadedModules(used).size() == 1);
+
+  // defining the name loads the module first, so it is not redefined.
+  Interpreter defined;
+  defined.eval(autoload);
+  REQUIRE_THROWS_AS(
+      defined.eval("<< >>\n<< >>\n<< 3 >>\n`triple\ndefine"), RuntimeError);
+  REQUIRE(loadedModules(defined).size() == 1);
+
+  // undefining it loads the module, then removes the name it defined.
+  Interpreter undefined;
+  undefined.eval(autoload);
+  undefined.eval("`triple\nundefine\n`triple\nbound?");
+  REQUIRE(top(undefined) == "false");
+  REQUIRE(loadedModules(undefined).size() == 1);
+
+  remove_all(dir);
+}
+
+TEST_CASE("images saved to files start other environments", "[modules]") {
+  path dir = makeDir("stacklangImageFile");
+  ofstream(dir / "triple.sta") << TRIPLE;
+  path image = dir / "triple.img";
+
+  Interpreter base;
+  base.include("std");
+  base.include((dir / "triple.sta").string());
+  base.eval("<< >>\n<< >>\n<< 4, triple >>\n`twelve\ndefine");
+  saveImage(image.string(), base.getRoot());
+
+  Interpreter loaded;
+  loadImage(image.string(), loaded.getRoot());
+  loaded.eval("twelve\n1\nincrement");
+  REQUIRE(top(loaded) == "2");
+  loaded.getStack().drop();
+  REQUIRE(top(loaded) == "12");
+  // the modules are recorded, so they are not run again.
+  REQUIRE(loadedModules(loaded).size() == loadedModules(base).size());
+  loaded.include((dir / "triple.sta").string());
+  REQUIRE(loaded.getStack().size() == 1);
+
+  ofstream(image) << "not an image";
+  Interpreter corrupt;
+  REQUIRE_THROWS_AS(loadImage(image.string(), corrupt.getRoot()),
+                    RuntimeError);
+  REQUIRE_THROWS_AS(loadImage((dir / "missing.img").string(),
+                              corrupt.getRoot()),
+                    RuntimeError);
+
+  remove_all(dir);
+}
@@ -22,17 +22,24 @@
 #include "language/stack/stackElements.h"
 
 #include <limits>
+#include <string>
 
 #include "catch.hpp"
 
 namespace {
+using stacklang::ElementPtr;
 using stacklang::Stack;
 using stacklang::StackElement;
+using stacklang::Value;
 using stacklang::exceptions::StackOverflowError;
 using stacklang::exceptions::StackUnderflowError;
 using stacklang::stackelements::NumberElement;
+using stacklang::stackelements::StringElement;
+using stacklang::stackelements::SubstackElement;
+using stacklang::stackelements::SubstackPtr;
 using stacklang::stackelements::TypeElement;
 using std::numeric_limits;
+using std::string;
 }  // namespace
 
 TEST_CASE("stack constructor sanity", "[Stack][constructor]") {
@@ -41,20 +48,19 @@ TEST_CASE("stack constructor sanity", "[Stack][constructor]") {
 }
 
 TEST_CASE("stack initializer", "[Stack][constructor]") {
-  NumberElement* elm1 = new NumberElement("1");
-  NumberElement* elm2 = new NumberElement("2");
+  StringElement* elm1 = new StringElement("1");
+  StringElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   REQUIRE(s.top() == elm2);
-  delete s.pop();
+  s.drop();
   REQUIRE(s.top() == elm1);
-  delete s.pop();
+  s.drop();
   REQUIRE(s.isEmpty());
 }
 
 TEST_CASE("stack initializer with type", "[Stack][constructor][type]") {
-  StackElement* elm = new TypeElement(StackElement::DataType::Command);
-  Stack s{elm};
-  REQUIRE(s.top() == elm);
+  Stack s{new TypeElement(StackElement::DataType::Command)};
+  REQUIRE(s.top() == Value(StackElement::DataType::Command));
 }
 
 TEST_CASE("stack initializer with JIT type", "[Stack][constructor][type]") {
@@ -65,38 +71,34 @@ TEST_CASE("stack initializer with JIT type", "[Stack][constructor][type]") {
 
 TEST_CASE("stack push, top, and pop", "[Stack][push][pop][top]") {
   Stack s;
-  NumberElement* elm1 = new NumberElement("1");
-  NumberElement* elm2 = new NumberElement("2");
+  StringElement* elm1 = new StringElement("1");
+  StringElement* elm2 = new StringElement("2");
   s.push(elm1);
   REQUIRE_FALSE(s.isEmpty());
   REQUIRE(s.top() == elm1);
   s.push(elm2);
-  StackElement* disc = s.pop();
-  REQUIRE(disc == elm2);
+  Value disc = s.pop();
+  REQUIRE(disc.get() == elm2);
   REQUIRE(s.top() == elm1);
-  delete disc;
 }
 
 TEST_CASE("stack clearing", "[Stack][clear]") {
-  NumberElement* elm1 = new NumberElement("1");
-  NumberElement* elm2 = new NumberElement("2");
+  StringElement* elm1 = new StringElement("1");
+  StringElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   s.clear();
   REQUIRE(s.isEmpty());
 }
 
 TEST_CASE("stack reverse", "[Stack][reverse]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
-  StackElement* elm3 = new NumberElement("3");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
+  StackElement* elm3 = new StringElement("3");
   Stack s{elm1, elm2, elm3};
   s.reverse();
-  REQUIRE(s.pop() == elm1);
-  delete elm1;
-  REQUIRE(s.pop() == elm2);
-  delete elm2;
-  REQUIRE(s.pop() == elm3);
-  delete elm3;
+  REQUIRE(s.pop().get() == elm1);
+  REQUIRE(s.pop().get() == elm2);
+  REQUIRE(s.pop().get() == elm3);
   REQUIRE(s.isEmpty());
 }
 
@@ -107,8 +109,8 @@ TEST_CASE("default stack limit", "[Stack][getLimit][constructor]") {
 
 TEST_CASE("stack size", "[Stack][size]") {
   Stack s;
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   REQUIRE(s.size() == 0);
   s.push(elm1);
   s.push(elm2);
@@ -118,36 +120,72 @@ TEST_CASE("stack size", "[Stack][size]") {
 }
 
 TEST_CASE("stack copy constructor", "[Stack][constructor]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   Stack sprime = s;
-  REQUIRE(sprime.top() != elm2);
-  REQUIRE(dynamic_cast<const NumberElement*>(sprime.top())->getData() == 2);
-  delete sprime.pop();
-  REQUIRE(sprime.top() != elm1);
-  REQUIRE(dynamic_cast<const NumberElement*>(sprime.top())->getData() == 1);
-  delete sprime.pop();
+  REQUIRE(sprime.top().get() == elm2);  // elements are shared, not cloned
+  ElementPtr popped(sprime.pop());
+  REQUIRE(popped.get() == elm2);
+  REQUIRE(popped.useCount() == 2);
+  REQUIRE(sprime.top() == elm1);
+  sprime.drop();
   REQUIRE(sprime.isEmpty());
+  REQUIRE(s.size() == 2);
+  REQUIRE(s.top() == elm2);
+}
+
+TEST_CASE("pushing onto a copy keeps references valid", "[Stack][push]") {
+  StackElement* elm1 = new StringElement("1");
+  Stack s{elm1};
+  Stack sprime = s;
+  const Value& top = s.top();
+  for (int i = 0; i < 100; i++) sprime.push(new StringElement("2"));
+  REQUIRE(top == elm1);
+  REQUIRE(s.size() == 1);
+  REQUIRE(sprime.size() == 101);
+  REQUIRE(sprime[100] == elm1);
+}
+
+TEST_CASE("taking the only reference to a substack keeps its buffer",
+          "[Stack][SubstackElement]") {
+  SubstackPtr sub(new SubstackElement(Stack{Value(1.0L, 0), Value(2.0L, 0)}));
+  const Value* first = &sub->getData()[0];
+  Stack taken = SubstackElement::take(sub);
+  REQUIRE(sub.get() == nullptr);
+  REQUIRE(&taken[0] == first);  // moved, not copied
+  taken.drop();
+  taken.push(Value(3.0L, 0));
+  REQUIRE(&taken[0] == first);  // replaced in place
+
+  // a substack seen elsewhere is copied, and left as it was.
+  SubstackPtr shared(new SubstackElement(taken));
+  SubstackPtr other = shared;
+  Stack copy = SubstackElement::take(shared);
+  copy.drop();
+  copy.push(Value(4.0L, 0));
+  REQUIRE(static_cast<string>(*other) == "<< 3, 1 >>");
+  REQUIRE(static_cast<string>(Value(new SubstackElement(copy))) ==
+          "<< 4, 1 >>");
 }
 
 TEST_CASE("stack move constructor", "[Stack][constructor]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack sprime = [&elm1, &elm2]() {
     Stack s{elm1, elm2};
     return s;
   }();
   REQUIRE(sprime.top() == elm2);
-  delete sprime.pop();
+  sprime.drop();
   REQUIRE(sprime.top() == elm1);
-  delete sprime.pop();
+  sprime.drop();
   REQUIRE(sprime.isEmpty());
 }
 
 TEST_CASE("stack iterator begin, end", "[Stack][stackIterator][begin][end]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   REQUIRE(*s.begin() == elm2);
   auto iter = s.begin();
@@ -157,8 +195,8 @@ TEST_CASE("stack iterator begin, end", "[Stack][stackIterator][begin][end]") {
 }
 
 TEST_CASE("stack iterator increment", "[Stack][stackIterator][increment]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   auto iter = s.begin();
   iter++;
@@ -168,60 +206,152 @@ TEST_CASE("stack iterator increment", "[Stack][stackIterator][increment]") {
 }
 
 TEST_CASE("stack setLimit valid", "[Stack][setLimit]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   REQUIRE_NOTHROW(s.setLimit(3));
   REQUIRE(s.getLimit() == 3);
 }
 
 TEST_CASE("stack setLimit too small", "[Stack][setLimit]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   REQUIRE_THROWS_AS(s.setLimit(1), StackOverflowError);
 }
 
 TEST_CASE("stack setLimit edge case", "[Stack][setLimit]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   REQUIRE_NOTHROW(s.setLimit(2));
   REQUIRE(s.getLimit() == 2);
 }
 
 TEST_CASE("stack pop underflow error", "[Stack][pop]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
   Stack s{elm1, elm2};
   REQUIRE_NOTHROW(s.pop());
-  delete elm2;
   REQUIRE_NOTHROW(s.pop());
-  delete elm1;
   REQUIRE_THROWS_AS(s.pop(), StackUnderflowError);
 }
 
 TEST_CASE("stack top underflow error", "[Stack][top]") {
-  StackElement* elm1 = new NumberElement("1");
+  StackElement* elm1 = new StringElement("1");
   Stack s{elm1};
   REQUIRE_NOTHROW(s.top());
-  delete s.pop();
+  s.drop();
   REQUIRE_THROWS_AS(s.top(), StackUnderflowError);
 }
 
 TEST_CASE("stack push overflow error", "[Stack][push]") {
-  StackElement* elm1 = new NumberElement("1");
-  StackElement* elm2 = new NumberElement("2");
-  StackElement* elm3 = new NumberElement("3");
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
+  StackElement* elm3 = new StringElement("3");
   Stack s(2);
   REQUIRE_NOTHROW(s.push(elm1));
   REQUIRE_NOTHROW(s.push(elm2));
   REQUIRE_THROWS_AS(s.push(elm3), StackOverflowError);
-  delete elm3;
 }
 
 TEST_CASE("stack constructor with size limit sanity", "[Stack][constructor]") {
   Stack s(4);
   REQUIRE(s.getLimit() == 4);
   REQUIRE(s.isEmpty());
-}
\ No newline at end of file
+}
+TEST_CASE("stack random access", "[Stack][at]") {
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
+  StackElement* elm3 = new StringElement("3");
+  Stack s{elm1, elm2, elm3};
+  REQUIRE(s[0] == elm3);
+  REQUIRE(s[2] == elm1);
+  REQUIRE(s.at(1) == elm2);
+  REQUIRE_THROWS_AS(s.at(3), StackUnderflowError);
+}
+
+TEST_CASE("stack rotate", "[Stack][rotate]") {
+  StackElement* elm1 = new StringElement("1");
+  StackElement* elm2 = new StringElement("2");
+  StackElement* elm3 = new StringElement("3");
+  Stack s{elm1, elm2, elm3};
+  s.rotate(3);
+  REQUIRE(s[0] == elm1);
+  REQUIRE(s[1] == elm3);
+  REQUIRE(s[2] == elm2);
+  s.rotate(3, 2);
+  REQUIRE(s[0] == elm3);
+  REQUIRE(s[1] == elm2);
+  REQUIRE(s[2] == elm1);
+  REQUIRE_THROWS_AS(s.rotate(4), StackUnderflowError);
+  REQUIRE(s.size() == 3);
+}
+
+TEST_CASE("stack copies push independently", "[Stack][constructor][push]") {
+  Stack s{Value(1.0L)};
+  Stack first = s;
+  Stack second = s;
+  first.push(Value(2.0L));
+  second.push(Value(3.0L));
+  REQUIRE(s.size() == 1);
+  REQUIRE(s.top().getNumber() == 1);
+  REQUIRE(first.size() == 2);
+  REQUIRE(first.top().getNumber() == 2);
+  REQUIRE(second.size() == 2);
+  REQUIRE(second.top().getNumber() == 3);
+  REQUIRE(second[1].getNumber() == 1);
+}
+
+TEST_CASE("stack copies modify independently", "[Stack][reverse][drop]") {
+  Stack s{new NumberElement("1"), new NumberElement("2"),
+          new NumberElement("3")};
+  Stack reversed = s;
+  reversed.reverse();
+  Stack dropped = s;
+  dropped.drop();
+  dropped.push(new NumberElement("4"));
+  REQUIRE(s.top().getNumber() == 3);
+  REQUIRE(s[1].getNumber() == 2);
+  REQUIRE(reversed.top().getNumber() == 1);
+  REQUIRE(dropped.top().getNumber() == 4);
+  REQUIRE(dropped[1].getNumber() == 2);
+}
+
+TEST_CASE("stack elements are freed with their last reference",
+          "[Stack][pop][clear]") {
+  size_t live = StackElement::getLiveCount();
+  Stack s{new StringElement("1"), new StringElement("2")};
+  Stack sprime = s;
+  REQUIRE(StackElement::getLiveCount() == live + 2);
+  ElementPtr popped(s.pop());
+  REQUIRE(popped.useCount() == 2);
+  s.clear();
+  sprime.clear();
+  REQUIRE(StackElement::getLiveCount() == live + 1);
+  REQUIRE(popped.useCount() == 1);
+  popped = nullptr;
+  REQUIRE(StackElement::getLiveCount() == live);
+}
+
+TEST_CASE("numbers, booleans and types are stored inline",
+          "[Stack][Value][push]") {
+  size_t allocated = StackElement::getAllocationCount();
+  Stack s;
+  s.push(Value(1.5L, 1));
+  s.push(Value(true));
+  s.push(Value(StackElement::DataType::Number));
+  REQUIRE(StackElement::getAllocationCount() == allocated);
+  REQUIRE(s[0].getType() == StackElement::DataType::Type);
+  REQUIRE(s[0].getBase() == StackElement::DataType::Number);
+  REQUIRE(s[1].getBoolean());
+  REQUIRE(s[2].getNumber() == 1.5L);
+  REQUIRE(s[2].getPrecision() == 1);
+  REQUIRE(s[0].get() == nullptr);
+
+  size_t live = StackElement::getLiveCount();
+  s.push(new NumberElement("2.50"));
+  REQUIRE(StackElement::getLiveCount() == live);  // unboxed and freed
+  REQUIRE(s.top() == Value(2.5L, 2));
+  REQUIRE(static_cast<std::string>(s.top()) == "2.50");
+}
@@ -0,0 +1,53 @@
+// Copyright 2018 Justin Hu, Bronwyn Damm, Jacques Marais, Ramon Rakow, and Jude
+// Sidloski
+//
+// This file is part of the StackLang interpreter.
+//
+// The StackLang interpreter is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The StackLang interpreter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the StackLang interpreter.  If not, see <https://www.gnu.org/licenses/>.
+
+// tests for interned symbols
+
+#include "language/stack/symbol.h"
+
+#include <string>
+
+#include "catch.hpp"
+
+namespace {
+using stacklang::Symbol;
+using std::string;
+}  // namespace
+
+TEST_CASE("symbols with the same name are the same", "[symbol]") {
+  Symbol first("foo-bar?");
+  Symbol second(string("foo-") + "bar?");
+  REQUIRE(first == second);
+  REQUIRE(first.getId() == second.getId());
+  REQUIRE(&first.getName() == &second.getName());
+}
+
+TEST_CASE("symbols with different names differ", "[symbol]") {
+  Symbol first("foo");
+  Symbol second("bar");
+  REQUIRE(first != second);
+  REQUIRE(first.getId() != second.getId());
+  REQUIRE(first.getName() == "foo");
+  REQUIRE(second.getName() == "bar");
+}
+
+TEST_CASE("symbol ids are dense", "[symbol]") {
+  Symbol first("dense-first-symbol");
+  Symbol second("dense-second-symbol");
+  REQUIRE(second.getId() == first.getId() + 1);
+}